@@ -0,0 +1,234 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: Crystal calibration with an external 1PPS (GPS).
+//**                The 1PPS is connected to IO_P1, the Si570 output
+//**                divided by an external prescaler (2^n) to IO_P2.
+//**                The rising edges of IO_P2 are counted by the pin
+//**                change interrupt over N seconds of the 1PPS, the
+//**                crystal frequency is then corrected by the ratio of
+//**                the counted and the expected edges.
+//**                The ATtiny85 timers can not count the input: the T0
+//**                pin is the USB D- line and Timer1 has no external
+//**                clock. The IO_P2 input must stay below about 10 kHz,
+//**                an edge is lost if two come during the USB interrupt.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_CAL
+
+static	cal_t		Cal;					// Calibration status & result
+static	uint8_t		CalSeconds;				// Seconds to count
+static	uint8_t		CalFlags;				// Prescaler log2 & write eeprom
+static	uint8_t		CalDdr;					// DDR bits of IO_P1 & IO_P2
+static	uint8_t		CalPort;				// PORT bits of IO_P1 & IO_P2
+static	uint8_t		CalDone;				// Number of handled 1PPS edges
+static	uint32_t	CalFirst;				// Edges at the first 1PPS edge
+static	uint32_t	CalFreq;				// Device frequency of the count
+#if INCLUDE_CHANNEL
+static	uint8_t		CalChannel;				// Si570 channel of the count
+#endif
+static	volatile uint8_t  CalPin;			// Last IO pin state
+static	volatile uint8_t  CalPps;			// Number of 1PPS edges
+static	volatile uint32_t CalEdges;			// Number of IO_P2 edges
+static	volatile uint32_t CalLatch;			// IO_P2 edges at the last 1PPS edge
+
+// The interrupts are enabled for the USB driver. The pin change interrupt
+// is off while the counters are changed, a new edge can not enter it again.
+ISR(PCINT0_vect, ISR_NOBLOCK)
+{
+	uint8_t pin, rise;
+
+	GIMSK &= ~_BV(PCIE);
+
+	pin  = IO_PIN;
+	rise = pin & ~CalPin;					// Rising edges only
+	CalPin = pin;
+
+	if (rise & _BV(IO_P2))
+		CalEdges += 1;
+
+	if (rise & _BV(IO_P1))
+	{
+		CalLatch = CalEdges;
+		CalPps += 1;
+	}
+
+	GIMSK |= _BV(PCIE);
+}
+
+// Stop the calibration, the I/O lines are set back to the old DDR and PORT.
+void
+CalStop(void)
+{
+	uint8_t mask = _BV(IO_P1) | _BV(IO_P2);
+
+	if (Cal.State == CAL_WAIT || Cal.State == CAL_COUNT)
+	{
+		GIMSK &= ~_BV(PCIE);
+		PCMSK = 0;
+
+		IO_DDR  |= CalDdr;
+		IO_PORT &= CalPort | ~mask;
+
+		Cal.State = CAL_IDLE;
+	}
+}
+
+// Start counting for seconds, flags is the prescaler log2 (bits 0..3)
+// and CAL_WRITE to use and save the result. The I/O lines are used by
+// the filter if the filter is switched on.
+uint8_t
+CalStart(uint8_t seconds, uint8_t flags)
+{
+	uint8_t mask = _BV(IO_P1) | _BV(IO_P2);
+
+	CalStop();
+
+#if INCLUDE_ABPF | INCLUDE_IBPF
+	if (FilterCrossOverOn)
+		return false;
+#endif
+
+	if (seconds == 0)
+		return false;
+
+	CalDdr  = IO_DDR & mask;
+	CalPort = IO_PORT & mask;
+	IO_DDR  &= ~mask;						// Input with pullup
+	IO_PORT |= mask;
+
+	CalSeconds = seconds;
+	CalFlags   = flags;
+	CalFreq    = DeviceFreq;
+#if INCLUDE_CHANNEL
+	CalChannel = Si570Channel;
+#endif
+	Cal.Seconds  = 0;
+	Cal.Count    = 0;
+	Cal.FreqXtal = 0;
+	Cal.State    = CAL_WAIT;
+
+	CalPin  = IO_PIN;
+	CalDone = CalPps;
+	PCMSK = mask;
+	GIFR  = _BV(PCIF);						// No old pending edge
+	GIMSK |= _BV(PCIE);
+
+	return true;
+}
+
+// The corrected crystal frequency, 0 if out of 1000 ppm.
+//   Expected = Freq[MHz] * 10^6 * N / 2^prescaler
+//   Xtal     = Xtal * Counted / Expected
+// With 10^6 / 2^21 = 15625 / 2^15 and 8 fraction bits of the expected
+// edges: Expected[24.8] = Freq[11.21] * N * 15625 / 2^(7+prescaler).
+static uint32_t
+CalXtal(void)
+{
+	uint32_t	expect;
+	uint32_t	xtal;
+	uint32_t	delta;
+
+	if (Cal.Count == 0 || Cal.Count >= _2(24))
+		return 0;
+
+	expect = CalcMulDiv(CalFreq, CalSeconds * 15625UL, _2(7 + (CalFlags & CAL_PRESCALER)), 0);
+	if (expect == 0)
+		return 0;
+
+	xtal = CalcMulDiv(R.FreqXtal, Cal.Count, expect, 8);
+
+	delta = xtal - R.FreqXtal;
+	if (delta >= _2(31)) delta = 0 - delta;
+	if (delta > (R.FreqXtal >> 10))		// Max 1000 ppm
+		return 0;
+
+	return xtal;
+}
+
+// Called from the main loop, handle the 1PPS edges.
+void
+CalPoll(void)
+{
+	uint32_t	edges;
+
+	if ((Cal.State != CAL_WAIT && Cal.State != CAL_COUNT) || CalDone == CalPps)
+		return;
+
+	CalDone = CalPps;
+
+	// A tune or channel select during the count is an error
+	if (DeviceFreq != CalFreq
+#if INCLUDE_CHANNEL
+	||	Si570Channel != CalChannel
+#endif
+	)
+	{
+		CalStop();
+		Cal.State = CAL_ERROR;
+		return;
+	}
+
+	cli();
+	edges = CalLatch;
+	sei();
+
+	if (Cal.State == CAL_WAIT)				// Start at the first 1PPS edge
+	{
+		CalFirst  = edges;
+		Cal.State = CAL_COUNT;
+		return;
+	}
+
+	Cal.Seconds += 1;
+	Cal.Count = edges - CalFirst;
+	if (Cal.Seconds < CalSeconds)
+		return;
+
+	CalStop();
+
+	Cal.FreqXtal = CalXtal();
+	Cal.State = Cal.FreqXtal != 0 ? CAL_DONE : CAL_ERROR;
+
+	if (Cal.State == CAL_DONE && (CalFlags & CAL_WRITE))
+	{
+		R.FreqXtal = Cal.FreqXtal;
+#if INCLUDE_TEMP_COMP
+		// The measured crystal has the running temperature correction,
+		// the crystal without it is Xtal / (1 + ppm / 10^8).
+		if (Si570Channel == 0)
+		{
+			TempXtal = CalcMulDiv(R.FreqXtal, 100000000UL, 100000000L + TempPpm, 0);
+			eeprom_write_block(&TempXtal, &E.FreqXtal, sizeof(E.FreqXtal));
+		}
+		else
+#endif
+		eeprom_write_block(&R.FreqXtal, ECHAN(FreqXtal), sizeof(E.FreqXtal));
+#if INCLUDE_CACHE
+		Si570CacheFlush();					// Cached registers are not valid
+#endif
+		SetFreq(R.Freq);
+	}
+}
+
+// Return the calibration status.
+cal_t*
+CalStatus(void)
+{
+	return &Cal;
+}
+
+#endif
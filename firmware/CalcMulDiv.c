@@ -0,0 +1,68 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: Multiply divide with a 64 bits intermediate result.
+//**                "Q = (A * B * 2^shift) / C", rounded.
+//**                CalcDivShift() does "Q = (P * 2^shift) / C" with a 64 bits
+//**                dividend and quotient, used by the high resolution freq.
+//**                The quotient must fit in 32 bits, the caller must check
+//**                the range of the input values.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_MULDIV
+
+// Q = (P * 2^shift) / C, rounded.
+static uint64_t
+CalcDivShift(uint64_t p, uint32_t c, uint8_t shift)
+{
+	uint32_t	r = 0;						// Remainder
+	uint64_t	q = 0;						// Quotient
+	uint8_t		cy;
+	uint8_t		cnt = 64 + shift;
+
+	// Skip the leading zero bytes of the dividend
+	while (cnt > 8 && (uint8_t)(p >> 56) == 0)
+	{
+		p <<= 8;
+		cnt -= 8;
+	}
+
+	do {
+		cy = (r & 0x80000000) != 0;			// Remainder bit 32
+		r = (r << 1) | (uint8_t)(p >> 63);
+		p <<= 1;
+		q <<= 1;
+		if (cy || r >= c)
+		{
+			r -= c;
+			q |= 1;
+		}
+	} while (--cnt);
+
+	// Round by the remainder
+	if ((r & 0x80000000) || (r << 1) >= c)
+		q += 1;
+
+	return q;
+}
+
+static uint32_t
+CalcMulDiv(uint32_t a, uint32_t b, uint32_t c, uint8_t shift)
+{
+	return CalcDivShift((uint64_t)a * b, c, shift);
+}
+
+#endif
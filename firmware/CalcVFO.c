@@ -108,4 +108,130 @@ CalcFreqMulAdd(uint32_t iFreq, uint32_t Sub, uint32_t Mul)
 	return oFreq;
 }
 
+#if INCLUDE_FREQ_HR
+
+// LO    = (freq  - offset) * multiply
+// 32.32 = (32.32 - 11.21)  * 11.21
+// The freq is less than 2^11 MHz, the 64 bits product is done in two parts.
+static
+uint64_t
+CalcFreqMulAddHR(uint64_t iFreq, uint32_t Sub, uint32_t Mul)
+{
+	uint32_t	hi, lo;
+
+	iFreq -= (uint64_t)Sub << 11;
+	iFreq &= FREQ_HR_MAX - 1;			// Wrap around as the 11.21 calculation
+
+	hi = iFreq >> 32;
+	lo = iFreq;
+
+	return (((uint64_t)hi * Mul) << 11) + (((uint64_t)lo * Mul) >> 21);
+}
+
 #endif
+
+#if INCLUDE_BAND_RATIO
+
+// P * m, byte by byte on the low n bytes of p (no 64 bits multiply).
+static
+uint64_t
+CalcMulByte(uint64_t p, uint8_t m, uint8_t n)
+{
+	uint8_t*	b = (uint8_t*)&p;
+	uint16_t	t = 0;
+
+	do {
+		t += (uint16_t)*b * m;
+		*b++ = t;
+		t >>= 8;
+	} while (--n);
+
+	return p;
+}
+
+// P / d, byte by byte on the low n bytes of p from the high byte, the
+// remainder is less than d. The leading zero bytes are skipped.
+static
+uint64_t
+CalcDivByte(uint64_t p, uint8_t d, uint8_t n)
+{
+	uint8_t*	b = (uint8_t*)&p + n;
+	uint16_t	r = 0;
+
+	while (n > 1 && b[-1] == 0)
+	{
+		--b;
+		--n;
+	}
+
+	do {
+		r = (r << 8) | *--b;
+		*b = r / d;
+		r %= d;
+	} while (--n);
+
+	return p;
+}
+
+// LO    = (freq  - offset) * num / den, or with the image set
+// LO    = (offset - freq)  * num / den
+// 11.21 = (11.21 - 11.21)  * 8.0 / 7.0
+// The offset subtract wraps around as CalcFreqMulAdd, the LO is rounded.
+// The ratio replaces the CalcFreqMulAdd pass, the LO is calculated with
+// 5 byte multiplies and 5 byte divides, the RFREQ is the 11.21 one.
+static
+uint32_t
+CalcFreqRatio(uint32_t iFreq, uint8_t band)
+{
+	uint64_t	Freq;
+	uint8_t		Den = R.BandDen[band];
+
+	if (Den & BAND_IMAGE)
+		iFreq = R.BandSub[band] - iFreq;
+	else
+		iFreq = iFreq - R.BandSub[band];
+
+	Freq = CalcMulByte(iFreq, R.BandNum[band], 5);
+
+	Den &= ~BAND_IMAGE;
+	if (Den > 1)
+		Freq = CalcDivByte(Freq + (Den >> 1), Den, 5);
+
+	return Freq;
+}
+
+#if INCLUDE_FREQ_HR
+
+// LO    = (freq  - offset) * num / den, or with the image set
+// LO    = (offset - freq)  * num / den
+// 32.32 = (32.32 - 11.21)  * 8.0 / 7.0
+// The offset is a signed value (two's complement), the LO is rounded.
+// The num / den step is 8 byte multiplies and 8 byte divides, the 64 bits
+// long division is the RFREQ calculation of the 32.32 frequency.
+static
+uint64_t
+CalcFreqRatioHR(uint64_t iFreq, uint8_t band)
+{
+	uint64_t	Sub = (uint64_t)R.BandSub[band] << 11;
+	uint8_t		Den = R.BandDen[band];
+
+	if (Den & BAND_IMAGE)
+		iFreq = Sub - iFreq;
+	else
+		iFreq = iFreq - Sub;
+	iFreq &= FREQ_HR_MAX - 1;			// Wrap around as the 11.21 calculation
+
+	iFreq = CalcMulByte(iFreq, R.BandNum[band], 8);
+
+	Den &= ~BAND_IMAGE;
+	if (Den > 1)
+		iFreq = CalcDivByte(iFreq + (Den >> 1), Den, 8);
+
+	return iFreq;
+}
+
+#endif
+
+#endif
+
+#endif
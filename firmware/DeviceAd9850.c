@@ -12,6 +12,8 @@
 //** Programmer...: F.W. Krom, PE0FKO
 //** 
 //** Description..: Control the AD9850 with the Si570 register commands.
+//**                The 40 bits tuning & control word is loaded serial
+//**                on DDS_DATA / DDS_W_CLK / DDS_FQ_UD (unrolled code).
 //**
 //** History......: V15.1 02/12/2008: First release of PE0FKO.
 //**                Check the main.c file
@@ -22,48 +24,67 @@
 
 #if INCLUDE_AD9850
 
-#include "CalcVFO.c"						// Include code is small size
+static	sint32_t	AD9850_Word;			// Tuning word of the DDS [0.32]
 
-#error "****** AD9850 Code not ready! ******"
+// Device interface of the AD9850, used by the SetFreq pipeline in Vfo.c.
+// A DDS is phase continuous, every change is a "large" change.
+#define	DevicePresent()		true			// No way to detect the DDS
+#define	DeviceCalc(freq)	AD9850_CalcWord(freq)
+#define	DeviceWriteSmall()	AD9850_Load()
+#define	DeviceWriteLarge()	AD9850_Load()
+#define	DeviceTuneSave(freq, path)
 
-static void
-AD9850_OutputByte(uint8_t code)
-{
-	uint8_t i;
-
-	for(i=0; i < 8; ++i)
-	{
-		if (code & 1)
-			bit_1(DDS_PORT, DDS_DATA);
-		else
-			bit_0(DDS_PORT, DDS_DATA);
-
-		bit_1(DDS_PORT, DDS_W_CLK);
-		code >>= 1;
-		bit_0(DDS_PORT, DDS_W_CLK);
-	}
-}
+#include "CalcVFO.c"						// Include code is small size
 
+// Serial load of one bit, LSB first. The data pin is written for every
+// bit, cleared for a 0 or set for a 1 (sbrs/cbi + sbrc/sbi is 5 cycles
+// either way), then a W_CLK pulse: 9 cycles a bit. The sbi/cbi are atomic, the USB
+// interrupt can stretch a clock but does not corrupt the port.
+#define	DDS_BIT(b,n)						\
+	"sbrs %[" #b "]," #n "      \n\t"		\
+	"cbi  %[port],%[data]     \n\t"		\
+	"sbrc %[" #b "]," #n "      \n\t"		\
+	"sbi  %[port],%[data]     \n\t"		\
+	"sbi  %[port],%[clk]      \n\t"		\
+	"cbi  %[port],%[clk]      \n\t"
+
+#define	DDS_BYTE(b)							\
+	DDS_BIT(b,0) DDS_BIT(b,1) DDS_BIT(b,2) DDS_BIT(b,3)	\
+	DDS_BIT(b,4) DDS_BIT(b,5) DDS_BIT(b,6) DDS_BIT(b,7)
+
+// Load the 32 bits tuning word (W0..W31) and the control / phase byte
+// (W32..W39) and strobe FQ_UD: 364 cycles = 22us @ 16.5 MHz.
+// The two control bits W32/W33 are factory test bits, kept 0.
 static void
-AD9850_Load(uint32_t freq)
+AD9850_Load(void)
 {
-	sint32_t Freq;
-	Freq.dw = freq;
+	asm volatile (
+	DDS_BYTE(w0)
+	DDS_BYTE(w1)
+	DDS_BYTE(w2)
+	DDS_BYTE(w3)
+	DDS_BYTE(ctrl)
 
-	AD9850_OutputByte(Freq.w0.b0);
-	AD9850_OutputByte(Freq.w0.b1);
-	AD9850_OutputByte(Freq.w1.b0);
-	AD9850_OutputByte(Freq.w1.b1);
+	"sbi  %[port],%[fqud]     \n\t"		// Move the word to the DDS
+	"cbi  %[port],%[fqud]     \n\t"
 
-	AD9850_OutputByte(R.ChipCrtlData);	// Phase / control word
-
-	bit_1(DDS_PORT, DDS_FQ_UD);
-	bit_0(DDS_PORT, DDS_FQ_UD);
+	// Input operand list
+	//-------------------
+	:
+	: [w0]   "r" (AD9850_Word.w0.b0)		// Tuning word LSB
+	, [w1]   "r" (AD9850_Word.w0.b1)
+	, [w2]   "r" (AD9850_Word.w1.b0)
+	, [w3]   "r" (AD9850_Word.w1.b1)		// Tuning word MSB
+	, [ctrl] "r" (R.ChipCrtlData & 0xFC)	// Power down & phase
+	, [port] "I" (_SFR_IO_ADDR(DDS_PORT))
+	, [data] "I" (DDS_DATA)
+	, [clk]  "I" (DDS_W_CLK)
+	, [fqud] "I" (DDS_FQ_UD)
+	);
 }
 
-
-void
-AD9850_LoadFreq(uint32_t freq)
+static uint8_t
+AD9850_CalcWord(uint32_t freq)
 {
 	uint8_t		cnt;
 	uint32_t	RR;						// Division remainder
@@ -76,6 +97,13 @@ AD9850_LoadFreq(uint32_t freq)
 	// [43.21] = [43.21] / [8.24]
 	// Count = Freq * 1(<<32) * 8 / Xtal
 	// [43.21] = [40.24] / [8.24]
+	//
+	// The output is limited to the Nyquist frequency, Xtal / 2, the
+	// Count is then less than 2^31 and fits the 32 bits quotient.
+	// [11.21] = [8.24] >> 3 >> 1
+
+	if (freq >= (R.FreqXtal >> 4))
+		return false;
 
 	//---------------------------------------------------------------------------
 	// Quotient_32 = Dividend_32 / Divisor_32
@@ -130,158 +158,47 @@ AD9850_LoadFreq(uint32_t freq)
 	"adc %C0,__zero_reg__\n\t"
 	"adc %D0,__zero_reg__\n\t"
 
-"L_X_%=:                 \n\t"
-
 	// Output operand list
 	//--------------------
 	: "=r" (Count)					// %0 -> Dividend_32
+	, "+r" (cnt)                    // %1 -> Loop_Counter
+	, "+r" (RR)                     // %2 -> Remainder_32
 
 	// Input operand list
 	//-------------------
-	: "r" (cnt)                     // %1 -> Loop_Counter
-	, "r" (RR)                      // %2 -> Remainder_32
-	, "r" (R.FreqXtal)              // %3 -> Divisor_32
+	: "r" (R.FreqXtal)              // %3 -> Divisor_32
 	, "0" (freq)
 	);
-	
-	AD9850_Load(Count);
-}
-
-
-void
-SetFreq(uint32_t freq)		// frequency [MHz] * 2^21
-{
-#if INCLUDE_FREQ_SM
-	freq = CalcFreqMulAdd(freq);
-#endif
-
-	R.Freq = freq;
 
-	AD9850_LoadFreq(freq);
+	AD9850_Word.dw = Count;
 
-#if INCLUDE_ABPF
-	SetFilter();
-#endif
+	return true;
 }
 
+#include "Vfo.c"							// Include code is small size
 
 void
 DeviceInit(void)
 {
-	// Clock in parallel data
-	bit_1(DDS_PORT, DDS_W_CLK);
-	bit_0(DDS_PORT, DDS_W_CLK);
-
-	// Enable serial mode
-	bit_1(DDS_PORT, DDS_FQ_UD);
-	bit_0(DDS_PORT, DDS_FQ_UD);
-
-	// Set startup Freq
-	SetFreq(R.Freq);
-}
-
-
-// Nodig voor Xtal calibratie!
-// Dont read from Si570 device, calc them from the (saved) frequency.
-uint8_t
-GetRegFromSi570(void)
-{
-	uint8_t		cnt;
-	uint32_t	RR;					// Division remainder
-	sint32_t	Freq;
+	bit_1(DDS_DDR, DDS_DATA);
+	bit_1(DDS_DDR, DDS_W_CLK);
+	bit_1(DDS_DDR, DDS_FQ_UD);
 
-	Freq.dw = R.Freq;
-
-	Si570_Data.HS_DIV = 0;			// HS_DIV = 0 (real divider = 4)
-	Si570_Data.N1 = 15>>2;			// N1 = 15 (real divider = 16)
-
-	// F = RFREQ * Xtal / (N1 * HS_DIV)
-	// RFREQ = F * (N1 * HS_DIV) / Xtal
-	// (N1 * HS_DIV) = 4 * 16 = 64
-	// RFREQ = F * 64 / Xtal
-	// [12.28] = [19.21] * 64 / [8.24]
-	// [12.28] = [16.24] * 2^3 * 2^6 * 2^28 / [8.24]
-	// RFREQ = 28.2 * 64 / 100 = 18,048
-
-	RR = 0;							// Clear Remainder_32
-	cnt = 40+1+28+3+6;				// Init Loop_Counter
-									// (28 = 12.28 bits, 3 = * 8, 2 = *4)
-	asm (
-	"clc                 \n\t"		// Partial_result = carry = 0
-
-"L_A_%=:                 \n\t"		// Repeat
-	"rol %0              \n\t"		//   Put last Partial_result in Quotient_40
-	"rol %1              \n\t"		//   and shift left Dividend_40 ...
-	"rol %2              \n\t"
-	"rol %3              \n\t"
-	"rol %4              \n\t"
-
-	"rol %A6             \n\t"		//                      ... into Remainder_32
-	"rol %B6             \n\t"
-	"rol %C6             \n\t"
-	"rol %D6             \n\t"
-
-	"sub %A6,%A7         \n\t"		//   Remainder =  Remainder - Divisor_32
-	"sbc %B6,%B7         \n\t"
-	"sbc %C6,%C7         \n\t"
-	"sbc %D6,%D7         \n\t"
-
-	"brcc L_B_%=         \n\t"		//   If result negative
-									//   Then
-	"add %A6,%A7         \n\t"		//     Restore Remainder
-	"adc %B6,%B7         \n\t"
-	"adc %C6,%C7         \n\t"
-	"adc %D6,%D7         \n\t"
-
-	"clc                 \n\t"		//     Partial_result = 0
-	"rjmp L_C_%=         \n\t"
-
-"L_B_%=:                 \n\t"		//   Else
-	"sec                 \n\t"		//     Partial_result = 1
-
-"L_C_%=:                 \n\t"		//   End If
-	"dec %5              \n\t"		// Until(--cnt == 0)
-	"brne L_A_%=         \n\t"
-
-	"adc %0,__zero_reg__\n\t"		// Round by the last bit of Count
-	"adc %1,__zero_reg__\n\t"
-	"adc %2,__zero_reg__\n\t"
-	"adc %3,__zero_reg__\n\t"
-	"adc %4,__zero_reg__\n\t"
-
-"L_X_%=:                 \n\t"
-
-	// Output operand list
-	//--------------------
-#if 0 //DEBUG
-	: "=r" (Si570_Data.RFREQ.w0.b0) // %0 -> Dividend_40 LSB
-	, "=r" (Si570_Data.RFREQ.w0.b1) // %1        "
-	, "=r" (Si570_Data.RFREQ.w1.b0) // %2        "
-	, "=r" (Si570_Data.RFREQ.w1.b1) // %3        "     
-	, "=r" (Si570_Data.RFREQ_b4)    // %4        "     MSB
-#else
-	: "=r" (Si570_Data.RFREQ.w1.b1) // %0 -> Dividend_40
-	, "=r" (Si570_Data.RFREQ.w1.b0) // %1        "
-	, "=r" (Si570_Data.RFREQ.w0.b1) // %2        "
-	, "=r" (Si570_Data.RFREQ.w0.b0) // %3        "     LSB
-	, "=r" (Si570_Data.RFREQ_b4)    // %4        "     MSB
-#endif
+	if (DevicePresent() && SI570_OffLine)
+	{
+		// Clock in parallel data
+		bit_1(DDS_PORT, DDS_W_CLK);
+		bit_0(DDS_PORT, DDS_W_CLK);
 
-	// Input operand list
-	//-------------------
-	: "r" (cnt)                     // %5 -> Loop_Counter
-	, "r" (RR)                      // %6 -> Remainder_32
-	, "r" (R.FreqXtal)              // %7 -> Divisor_32
-	, "0" (Freq.w0.b0)              //  0 -> Dividend_40 LSB
-	, "1" (Freq.w0.b1)              //  1 -> Dividend_40
-	, "2" (Freq.w1.b0)              //  2 -> Dividend_40
-	, "3" (Freq.w1.b1)              //  3 -> Dividend_40
-	, "4" (0)                       //  4 -> Dividend_40 MSB
-	);
+		// Enable serial mode
+		bit_1(DDS_PORT, DDS_FQ_UD);
+		bit_0(DDS_PORT, DDS_FQ_UD);
 
-	Si570_Data.RFREQ_b4 |= 15<<6;	// N1 = 15 (real divider = 16)
+		// Set startup Freq
+		SetFreq(R.Freq);
 
-	return sizeof(Si570_t);
+		SI570_OffLine = false;
+	}
 }
 
 #endif
@@ -0,0 +1,245 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial 
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//** 
+//** Description..: Control the Si5351 with the Si570 register commands.
+//**                PLL A is fractional (denominator 2^19), the multisynth
+//**                dividers are even integers (low jitter). With the
+//**                quadrature on, CLK0 & CLK1 are the freq / 4 with 90
+//**                degree phase offset, no 4x LO and Johnson counter.
+//**                A small change only writes the changed PLL registers.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_SI5351
+
+static	uint16_t	Si5351_Div;				// Multisynth divider (even), 0 = not loaded
+static	uint8_t		Si5351_Pll[8];			// PLL A registers 26..33, value in the chip
+static	uint8_t		Si5351_New[8];			// PLL A registers 26..33, calculated
+
+static void Si5351WriteSmall(void);
+static void Si5351WriteLarge(void);
+
+// Device interface of the Si5351, used by the SetFreq pipeline in Vfo.c.
+// The small change keeps the multisynth divider and only moves the PLL,
+// there is no smooth tune ppm window, only the PLL range.
+#define	DevicePresent()		((I2C_PIN & _BV(BIT_SCL)) != 0)	// SCL Low is power off
+#define	DeviceCalc(freq)	Si5351CalcRegs(freq)
+#define	DeviceCalcSmall(freq)	Si5351CalcSmall(freq)
+#define	DeviceWriteSmall()	Si5351WriteSmall()
+#define	DeviceWriteLarge()	Si5351WriteLarge()
+#define	DeviceTuneSave(freq, path)
+
+#include "CalcMulDiv.c"						// Include code is small size
+#include "CalcVFO.c"						// Include code is small size
+
+// Calculate the PLL A registers of the VCO freq * div. The feedback
+// divider a + b / c with c = 2^19 is the fixed point [a.19] value:
+//   P1 = 128 * a + (128 * b / c) - 512 = [a.19] >> 12 - 512
+//   P2 = 128 * b % c                   = [a.19] << 7 & (2^19-1)
+//   P3 = c                             = 2^19
+static uint8_t
+Si5351CalcPll(uint32_t freq, uint16_t div)
+{
+	sint32_t	P1, P2;
+
+	// The VCO (freq * div) must be in the range, 900 MHz is 11.21 bits.
+	// The product can overflow 32 bits, compare freq with the range / div.
+	if (freq < ((uint32_t)PLL_MIN << 21) / div || freq > ((uint32_t)PLL_MAX << 21) / div)
+		return false;
+
+	// [a.19] = [11.21] * [16.0] * 2^22 / [8.24]
+	P1.dw = CalcMulDiv(freq, div, R.FreqXtal, 22);
+	P2.dw = (P1.dw << 7) & (_2(19) - 1);
+	P1.dw = (P1.dw >> 12) - 512;
+
+	Si5351_New[0] = 0x00;					// P3[15:8]
+	Si5351_New[1] = 0x00;					// P3[7:0]
+	Si5351_New[2] = P1.w1.b0 & 0x03;		// P1[17:16]
+	Si5351_New[3] = P1.w0.b1;				// P1[15:8]
+	Si5351_New[4] = P1.w0.b0;				// P1[7:0]
+	Si5351_New[5] = 0x80 | P2.w1.b0;		// P3[19:16] P2[19:16]
+	Si5351_New[6] = P2.w0.b1;				// P2[15:8]
+	Si5351_New[7] = P2.w0.b0;				// P2[7:0]
+
+	return true;
+}
+
+// Output frequency of CLK0 (& CLK1), the host asks 4x LO if quadrature.
+static uint32_t
+Si5351FreqOut(uint32_t freq)
+{
+	return R.Si5351Quad ? freq >> 2 : freq;
+}
+
+// Large change: the lowest even divider of the lowest VCO frequency.
+// The quadrature phase offset is the divider, only 7 bits.
+static uint8_t
+Si5351CalcRegs(uint32_t freq)
+{
+	uint16_t	div;
+	sint32_t	Freq;
+
+	Freq.dw = Si5351FreqOut(freq);
+
+	if (Freq.w1.w < 1 * _2(5))				// Below 1 MHz (11.5 bits)
+		return false;
+
+	// 16.0 bits = 13.3 bits / (11.5 bits >> 2), one to low
+	div = (PLL_MIN * _2(3)) / (Freq.w1.w >> 2) + 1;
+	div = (div + 1) & ~1;
+	if (div < 6)
+		div = 6;
+
+	if (R.Si5351Quad && div > SI5351_PHASE_MAX)
+		return false;
+
+	if (!Si5351CalcPll(Freq.dw, div))
+		return false;
+
+	Si5351_Div = div;
+	return true;
+}
+
+// Small change: the same divider, only the PLL is moved.
+static uint8_t
+Si5351CalcSmall(uint32_t freq)
+{
+	return Si5351_Div != 0 && Si5351CalcPll(Si5351FreqOut(freq), Si5351_Div);
+}
+
+static uint8_t
+Si5351CmdStart(uint8_t reg)
+{
+	I2CSendStart();
+	I2CSendByte((R.ChipCrtlData<<1)|0);	// send device address 
+	if (I2CErrors == 0)
+	{
+		I2CSendByte(reg);				// send register address
+		return true;
+	}
+	return false;
+}
+
+static void
+Si5351CmdReg(uint8_t reg, uint8_t data)
+{
+	if (Si5351CmdStart(reg))
+	{
+		I2CSendByte(data);
+	}
+	I2CSendStop();
+}
+
+// Write a block of registers (auto increment of the register address)
+static void
+Si5351CmdBlock(uint8_t reg, uint8_t* data, uint8_t n)
+{
+	if (Si5351CmdStart(reg))
+	{
+		while (n--)
+			I2CSendByte(*data++);
+	}
+	I2CSendStop();
+}
+
+// Write the PLL registers from the first changed one up to register 33,
+// P1 & P2 are taken as a whole. Most small changes only write P2.
+// On a write error the divider is cleared, the next change is large.
+static void
+Si5351WriteSmall(void)
+{
+	uint8_t		i;
+
+	for (i = 0; i < sizeof(Si5351_New); ++i)
+		if (Si5351_New[i] != Si5351_Pll[i])
+			break;
+
+	if (i == sizeof(Si5351_New))
+		return;
+
+	Si5351CmdBlock(26 + i, &Si5351_New[i], sizeof(Si5351_New) - i);
+
+	if (I2CErrors == 0)
+		memcpy(Si5351_Pll, Si5351_New, sizeof(Si5351_Pll));
+	else
+		Si5351_Div = 0;
+}
+
+// Write the multisynth dividers (integer: P1 = 128 * div - 512, P2 = 0,
+// P3 = 1), the quadrature phase offset and all PLL registers. The PLL
+// reset aligns the phase of CLK0 & CLK1.
+static void
+Si5351WriteLarge(void)
+{
+	uint8_t		ms[8];
+	sint32_t	P1;
+
+	P1.dw = 128 * (uint32_t)Si5351_Div - 512;
+
+	ms[0] = 0x00;							// P3[15:8]
+	ms[1] = 0x01;							// P3[7:0]
+	ms[2] = P1.w1.b0 & 0x03;				// R0_DIV = 1, MS0_DIVBY4 = 0, P1[17:16]
+	ms[3] = P1.w0.b1;						// P1[15:8]
+	ms[4] = P1.w0.b0;						// P1[7:0]
+	ms[5] = 0x00;							// P3[19:16] P2[19:16]
+	ms[6] = 0x00;							// P2[15:8]
+	ms[7] = 0x00;							// P2[7:0]
+
+	Si5351CmdBlock(42, ms, sizeof(ms));		// Multisynth 0
+	if (R.Si5351Quad)
+	{
+		Si5351CmdBlock(50, ms, sizeof(ms));	// Multisynth 1
+		Si5351CmdReg(166, Si5351_Div);		// CLK1 phase offset 90 degree
+	}
+
+	Si5351CmdBlock(26, Si5351_New, sizeof(Si5351_New));
+	Si5351CmdReg(177, 0x20);				// Reset PLL A
+
+	if (I2CErrors == 0)
+		memcpy(Si5351_Pll, Si5351_New, sizeof(Si5351_Pll));
+	else
+		Si5351_Div = 0;
+}
+
+#include "Vfo.c"							// Include code is small size
+
+void
+DeviceInit(void)
+{
+	// Check if Si5351 is online and intialize if nessesary
+	if (DevicePresent())
+	{
+		if (SI570_OffLine)
+		{
+			Si5351CmdReg(3, 0xFF);			// Disable all outputs
+			Si5351CmdReg(16, 0x4F);			// CLK0 on: integer, PLL A, multisynth 0, 8mA
+			Si5351CmdReg(17, R.Si5351Quad ? 0x4F : 0x80);	// CLK1 on (multisynth 1) or off
+			Si5351CmdReg(18, 0x80);			// CLK2 off
+
+			Si5351_Div = 0;					// Next SetFreq is a large change
+			SetFreq(R.Freq);
+
+			Si5351CmdReg(3, R.Si5351Quad ? 0xFC : 0xFE);	// Enable CLK0 (& CLK1)
+
+			SI570_OffLine = I2CErrors;
+		}
+	}
+	else 
+	{
+		SI570_OffLine = true;
+	}
+}
+
+#endif
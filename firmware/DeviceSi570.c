@@ -34,7 +34,62 @@ static	uint8_t		Si570_HS_DIV;			// The high speed divider
 #endif
 static	void		Si570WriteSmallChange(void);
 static	void		Si570WriteLargeChange(void);
+#if INCLUDE_TUNE_STATUS
+		tune_t		Si570Tune;				// Last tune of the Si570
+#endif
+#if INCLUDE_FREQ_HR
+		uint64_t	FreqHR;					// Running frequency[MHz] (32.32bits)
+#endif
+
+#if INCLUDE_CHANNEL
+typedef struct
+{
+		uint32_t	Freq;					// Running frequency[MHz] (11.21bits)
+		Si570_t		Reg;					// Si570 register values
+		uint16_t	N;						// Total division (N1 * HS_DIV)
+		uint8_t		N1;						// The slow divider
+		uint8_t		HS_DIV;					// The high speed divider
+		uint8_t		OffLine;				// Si570 offline
+#if INCLUDE_SMOOTH
+		uint32_t	FreqSmoothTune;			// The smooth tune center frequency
+#endif
+#if INCLUDE_BAND_CACHE
+		uint16_t	BandLow;				// Cached band bounds and number
+		uint16_t	BandHigh;
+		uint8_t		BandCur;
+#endif
+#if INCLUDE_CAL | INCLUDE_TEMP_COMP
+		uint32_t	DeviceFreq;				// Device output frequency[MHz] (11.21bits)
+#endif
+#if INCLUDE_TEMP_COMP && INCLUDE_RFREQ_HR
+		uint64_t	DeviceFreqHR;			// Device output frequency[MHz] (32.32bits)
+#endif
+} chan_t;
+
+// The running state of the selected channel is in the globals, the state
+// of the other channels is in Si570Chan[channel-1]. If channel c is
+// selected, the state of channel 0 is kept in Si570Chan[c-1].
+static	chan_t		Si570Chan[SI570_CHANNELS-1];
+		uint8_t		Si570Channel;			// Selected channel
+#endif
+
+#if INCLUDE_CACHE
+typedef struct
+{
+		uint32_t	Freq;					// Si570 frequency[MHz] (11.21bits)
+		Si570_t		Reg;					// Si570 register values
+#if INCLUDE_CHANNEL
+		uint8_t		Channel;				// Si570 channel of the registers
+#endif
+} cache_t;
 
+static	cache_t		Si570Cache[CACHE_SIZE];	// Calculated registers, most recent first
+static	uint8_t		Si570CacheUsed;			// Number of used cache entries
+		uint16_t	Si570CacheHit;			// Number of cache hits
+		uint16_t	Si570CacheMiss;			// Number of cache misses
+#endif
+
+#include "CalcMulDiv.c"						// Include code is small size
 #include "CalcVFO.c"						// Include code is small size
 
 // Cost: 140us
@@ -336,6 +391,49 @@ Si570CalcRFREQ(uint32_t freq)
 }
 
 
+#if INCLUDE_RFREQ_HR
+
+// RFREQ = freq * N / Xtal, with the high resolution frequency.
+// RFREQ[12.28] = (freq[32.32] * N[16.0] * 2^20) / xtal[8.24]
+static uint8_t
+Si570CalcRFREQHR(uint64_t freq)
+{
+	uint64_t	DCO;
+	uint64_t	RFREQ;
+	uint8_t		sN1;
+
+	// Convert divider ratio to SI570 register value
+	sN1 = Si570_N1 - 1;
+	Si570_Data.N1      = sN1 >> 2;
+	Si570_Data.HS_DIV  = Si570_HS_DIV - 4;
+
+	// The freq is less than 2^11 MHz and N less than 2^11, DCO fits in 64 bits
+	DCO = freq * Si570_N;
+
+	// Check if DCO is lower than the Si570 max specied.
+#if INCLUDE_SI570_GRADE
+	if ((uint16_t)(DCO >> 32) > R.Si570DCOMax)
+		return 0;
+#else
+	if ((uint16_t)(DCO >> 32) > DCO_MAX)
+		return 0;
+#endif
+
+	RFREQ = CalcDivShift(DCO, R.FreqXtal, 20);
+
+	Si570_Data.RFREQ.w0.b0 = RFREQ >> 24;		// Big endian as the Si570 registers
+	Si570_Data.RFREQ.w0.b1 = RFREQ >> 16;
+	Si570_Data.RFREQ.w1.b0 = RFREQ >> 8;
+	Si570_Data.RFREQ.w1.b1 = RFREQ;
+
+	Si570_Data.RFREQ_b4  = (RFREQ >> 32) & 0x3F;
+	Si570_Data.RFREQ_b4 |= (sN1 & 0x03) << 6;
+
+	return 1;
+}
+
+#endif
+
 #if INCLUDE_SMOOTH
 
 static uint8_t
@@ -369,126 +467,298 @@ Si570_Small_Change(uint32_t current_Frequency)
 
 #endif
 
-#if INCLUDE_IBPF
+#if INCLUDE_TUNE_STATUS
 
-static uint8_t
-GetFreqBand(uint32_t freq)
+// Save the asked frequency and the registers of the tune, the achieved
+// frequency and error are calculated by the status command.
+static void
+Si570TuneSave(uint32_t freq, uint8_t path)
 {
-	uint8_t n;
-	sint32_t Freq;
+	Si570Tune.FreqLO = (uint64_t)freq << 11;
+	Si570Tune.Reg    = Si570_Data;
+	Si570Tune.Path   = path;
+}
 
-	Freq.dw = freq;
+#else
+#define	Si570TuneSave(freq, path)
+#endif
 
-	for(n=0; n < MAX_BAND-1; ++n)
-		if (Freq.w1.w < R.FilterCrossOver[n].w)
-			return n;
+#if INCLUDE_PRESET | INCLUDE_CACHE
 
-	return MAX_BAND-1;
+// Set the dividers from the Si570 register values.
+static void
+Si570RegDivider(void)
+{
+	Si570_HS_DIV = Si570_Data.HS_DIV + 4;
+	Si570_N1     = ((Si570_Data.N1 << 2) | (Si570_Data.RFREQ_b4 >> 6)) + 1;
+	Si570_N      = Si570_N1 * Si570_HS_DIV;
 }
 
+#endif
+
+#if INCLUDE_CACHE
+
+// Flush the cache, the crystal frequency or grade is changed.
 void
-SetFilter(uint8_t filter)
+Si570CacheFlush(void)
 {
-	if (FilterCrossOverOn)
-	{
-		bit_1(IO_DDR, IO_P1);
-		bit_1(IO_DDR, IO_P2);
+	Si570CacheUsed = 0;
+}
 
-		if (filter & 0x01)
-			bit_1(IO_PORT, IO_P1);
-		else
-			bit_0(IO_PORT, IO_P1);
+#endif
 
-		if (filter & 0x02)
-			bit_1(IO_PORT, IO_P2);
-		else
-			bit_0(IO_PORT, IO_P2);
+// Calculate the dividers and RFREQ for a large change.
+// The cache is a LRU list, a hit will skip all the calculations.
+static uint8_t
+Si570CalcRegs(uint32_t freq)
+{
+#if INCLUDE_CACHE
+	cache_t		entry;
+	uint8_t		i;
+
+	for (i = 0; i < Si570CacheUsed; ++i)
+		if (Si570Cache[i].Freq == freq
+#if INCLUDE_CHANNEL
+		&&	Si570Cache[i].Channel == Si570Channel
+#endif
+		)
+			break;
+
+	if (i < Si570CacheUsed)
+	{
+		Si570CacheHit += 1;
+		entry = Si570Cache[i];
+		Si570_Data = entry.Reg;
+		Si570RegDivider();
 	}
+	else
+	{
+		Si570CacheMiss += 1;
+		if (!Si570CalcDivider(freq) || !Si570CalcRFREQ(freq))
+			return false;
+
+		entry.Freq = freq;
+		entry.Reg  = Si570_Data;
+#if INCLUDE_CHANNEL
+		entry.Channel = Si570Channel;
+#endif
+		if (Si570CacheUsed < CACHE_SIZE)
+			Si570CacheUsed += 1;
+		i = Si570CacheUsed - 1;				// Drop the last used entry if full
+	}
+
+	// Move the entry to the front of the list
+	memmove(&Si570Cache[1], &Si570Cache[0], i * sizeof(cache_t));
+	Si570Cache[0] = entry;
+
+	return true;
+#else
+	return Si570CalcDivider(freq) && Si570CalcRFREQ(freq);
+#endif
 }
 
+// Device interface of the Si570, used by the SetFreq pipeline in Vfo.c.
+#define	DevicePresent()		((I2C_PIN & _BV(BIT_SCL)) != 0)	// SCL Low is power off
+#define	DeviceWriteSmall()	Si570WriteSmallChange()
+#define	DeviceWriteLarge()	Si570WriteLargeChange()
+#define	DeviceTuneSave(freq, path)	Si570TuneSave(freq, path)
+
+static uint8_t
+DeviceCalc(uint32_t freq)
+{
+	if (!Si570CalcRegs(freq))
+		return false;
+#if INCLUDE_SMOOTH
+	FreqSmoothTune = freq;					// New center of the smooth tune window
 #endif
+	return true;
+}
 
-void
-SetFreq(uint32_t freq)		// frequency [MHz] * 2^21
+#if INCLUDE_SMOOTH
+
+static uint8_t
+DeviceCalcSmall(uint32_t freq)
 {
-	R.Freq = freq;			// Save the asked freq
+	if ((R.SmoothTunePPM == 0) || !Si570_Small_Change(freq))
+		return false;
+	Si570CalcRFREQ(freq);
+	return true;
+}
 
-#if INCLUDE_IBPF
+#endif
 
-	uint8_t band = GetFreqBand(freq);
+#if INCLUDE_RFREQ_HR
+
+static uint8_t
+DeviceCalcHR(uint64_t freq)
+{
+	uint32_t	lo = freq >> 11;
+
+	if (!Si570CalcDivider(lo) || !Si570CalcRFREQHR(freq))
+		return false;
+#if INCLUDE_SMOOTH
+	FreqSmoothTune = lo;
+#endif
+	return true;
+}
 
-	freq = CalcFreqMulAdd(freq, R.BandSub[band], R.BandMul[band]);
+#if INCLUDE_SMOOTH
 
-	SetFilter(R.Band2Filter[band]);
+static uint8_t
+DeviceCalcSmallHR(uint64_t freq)
+{
+	if ((R.SmoothTunePPM == 0) || !Si570_Small_Change(freq >> 11))
+		return false;
+	Si570CalcRFREQHR(freq);
+	return true;
+}
 
 #endif
 
-//#ifdef INCLUDE_ABPF	<<-- Bug in V15.12
-#if INCLUDE_ABPF
-	if (FilterCrossOverOn)
-	{
-		sint32_t Freq;
-		Freq.dw = R.Freq;			// Freq.w1 is 11.5bits
+static void
+DeviceTuneSaveHR(uint64_t freq, uint8_t path)
+{
+	Si570TuneSave(freq >> 11, path);
+#if INCLUDE_TUNE_STATUS
+	Si570Tune.FreqLO = freq;
+#endif
+}
 
-		bit_1(IO_DDR, IO_P1);
-		bit_1(IO_DDR, IO_P2);
+#endif
 
-		if (Freq.w1.w < R.FilterCrossOver[0].w)
-		{
-			bit_0(IO_PORT, IO_P1);
-			bit_0(IO_PORT, IO_P2);
-		}
-		else 
-		if (Freq.w1.w < R.FilterCrossOver[1].w)
-		{
-			bit_1(IO_PORT, IO_P1);
-			bit_0(IO_PORT, IO_P2);
-		}
-		else 
-		if (Freq.w1.w < R.FilterCrossOver[2].w)
-		{
-			bit_0(IO_PORT, IO_P1);
-			bit_1(IO_PORT, IO_P2);
-		}
-		else 
+#include "Vfo.c"							// Include code is small size
+
+#if INCLUDE_TEMP_COMP
+
+// Retune the running frequency after a change of the crystal frequency,
+// with the same dividers: only RFREQ is written (small change). A tune
+// of the high resolution path is retuned with all the bits. Nothing is
+// written if the DCO is out of range.
+static void
+DeviceRetune(void)
+{
+#if INCLUDE_RFREQ_HR
+	if (DeviceFreqHR != 0)
+	{
+		if (Si570CalcRFREQHR(DeviceFreqHR))
 		{
-			bit_1(IO_PORT, IO_P1);
-			bit_1(IO_PORT, IO_P2);
+			DeviceTuneSaveHR(DeviceFreqHR, TUNE_SMALL);
+			Si570WriteSmallChange();
 		}
+		return;
 	}
 #endif
 
-#if INCLUDE_FREQ_SM
-
-	freq = CalcFreqMulAdd(freq, R.FreqSub, R.FreqMul);
+	if (DeviceFreq != 0 && Si570CalcRFREQ(DeviceFreq))
+	{
+		Si570TuneSave(DeviceFreq, TUNE_SMALL);
+		Si570WriteSmallChange();
+	}
+}
 
 #endif
 
-#if INCLUDE_SMOOTH
+#if INCLUDE_PRESET
+
+// Calculate the filter and Si570 registers of the frequency, without
+// changing the running frequency. On error the preset freq is set to 0.
+uint8_t
+Si570CalcPreset(uint32_t freq, preset_t* p)
+{
+	uint16_t	sN		= Si570_N;			// Save the running dividers
+	uint8_t		sN1		= Si570_N1;
+	uint8_t		sHS_DIV	= Si570_HS_DIV;
+	Si570_t		sData	= Si570_Data;
+	uint8_t		ok;
+
+	p->Freq = freq;
+
+#if INCLUDE_IBPF
+	uint8_t band = GetFreqBand(freq);
 
-	if ((R.SmoothTunePPM != 0) && Si570_Small_Change(freq))
+	p->Filter = R.Band2Filter[band];
+
+	if (Si570Channel == 0)				// The band transform is of the LO
 	{
-		Si570CalcRFREQ(freq);
-		Si570WriteSmallChange();
+#if INCLUDE_BAND_RATIO
+		if (R.BandNum[band] != 0)
+			freq = CalcFreqRatio(freq, band);
+		else
+#endif
+		freq = CalcFreqMulAdd(freq, R.BandSub[band], R.BandMul[band]);
 	}
-	else
-	{
-		if (!Si570CalcDivider(freq) || !Si570CalcRFREQ(freq))
-			return;
+#endif
+
+#if INCLUDE_FREQ_SM
+	freq = CalcFreqMulAdd(freq, R.FreqSub, R.FreqMul);
+#endif
+
+	p->FreqLO = freq;
+
+	ok = Si570CalcRegs(freq);
+	if (!ok)
+		p->Freq = 0;
+	p->Reg = Si570_Data;
 
-		FreqSmoothTune = freq;
-		Si570WriteLargeChange();
+	Si570_N      = sN;
+	Si570_N1     = sN1;
+	Si570_HS_DIV = sHS_DIV;
+	Si570_Data   = sData;
+
+	return ok;
+}
+
+// Load the preset in the Si570, no calculations needed.
+// Only the RFREQ is written if the dividers are the same and the
+// frequency is within the smooth tune window.
+void
+Si570LoadPreset(preset_t* p)
+{
+	uint8_t		sN1		= Si570_N1;
+	uint8_t		sHS_DIV	= Si570_HS_DIV;
+
+	if (p->Freq == 0)
+		return;
+
+	R.Freq = p->Freq;
+
+	if (Si570Channel == 0)
+	{
+#if INCLUDE_IBPF
+		SetFilter(p->Filter);
+#endif
+#if INCLUDE_FILTER_BANK
+		SetTxFilter(p->Freq);
+#endif
 	}
 
-#else
+	Si570_Data = p->Reg;
+	Si570RegDivider();
+
+#if INCLUDE_CAL | INCLUDE_TEMP_COMP
+	DeviceFreq = p->FreqLO;					// The dividers of the preset are running
+#endif
+#if INCLUDE_TEMP_COMP && INCLUDE_RFREQ_HR
+	DeviceFreqHR = 0;
+#endif
 
-	if (!Si570CalcDivider(freq) || !Si570CalcRFREQ(freq))
+#if INCLUDE_SMOOTH
+	if ((R.SmoothTunePPM != 0) && Si570_N1 == sN1 && Si570_HS_DIV == sHS_DIV
+	&&	Si570_Small_Change(p->FreqLO))
+	{
+		Si570TuneSave(p->FreqLO, TUNE_SMALL);
+		Si570WriteSmallChange();
 		return;
+	}
+
+	FreqSmoothTune = p->FreqLO;
+#endif
 
+	Si570TuneSave(p->FreqLO, TUNE_LARGE);
 	Si570WriteLargeChange();
+}
 
 #endif
-}
 
 #if INCLUDE_SI570_GRADE
 
@@ -534,12 +804,115 @@ Auto_index_detect_RFREQ(void)
 }
 #endif
 
+#if INCLUDE_CHANNEL
+
+static void
+MemSwap(void* a, void* b, uint8_t n)
+{
+	uint8_t* p = a;
+	uint8_t* q = b;
+
+	while (n--)
+	{
+		uint8_t t = *p;
+		*p++ = *q;
+		*q++ = t;
+	}
+}
+
+#define	SWAP(a,b)	MemSwap(&(a), &(b), sizeof(a))
+
+// Exchange the running state & config and the state & config of channel c (1..)
+static void
+Si570ChannelSwap(uint8_t c)
+{
+	chan_t*		s = &Si570Chan[c-1];
+	chancfg_t*	cfg = &R.Chan[c-1];
+
+	SWAP(R.Freq,			s->Freq);
+	SWAP(Si570_Data,		s->Reg);
+	SWAP(Si570_N,			s->N);
+	SWAP(Si570_N1,			s->N1);
+	SWAP(Si570_HS_DIV,		s->HS_DIV);
+	SWAP(SI570_OffLine,		s->OffLine);
+#if INCLUDE_SMOOTH
+	SWAP(FreqSmoothTune,	s->FreqSmoothTune);
+#endif
+#if INCLUDE_BAND_CACHE
+	SWAP(BandLow,			s->BandLow);
+	SWAP(BandHigh,			s->BandHigh);
+	SWAP(BandCur,			s->BandCur);
+#endif
+#if INCLUDE_CAL | INCLUDE_TEMP_COMP
+	SWAP(DeviceFreq,		s->DeviceFreq);
+#endif
+#if INCLUDE_TEMP_COMP && INCLUDE_RFREQ_HR
+	SWAP(DeviceFreqHR,		s->DeviceFreqHR);
+#endif
+
+	SWAP(R.FreqXtal,		cfg->FreqXtal);
+#if INCLUDE_SI570_GRADE
+	SWAP(R.Si570DCOMin,		cfg->Si570DCOMin);
+	SWAP(R.Si570DCOMax,		cfg->Si570DCOMax);
+	SWAP(R.Si570Grade,		cfg->Si570Grade);
+	SWAP(R.Si570RFREQIndex,	cfg->Si570RFREQIndex);
+#endif
+	SWAP(R.ChipCrtlData,	cfg->ChipCrtlData);
+}
+
+// Program the other channels with their own startup frequency, a channel
+// that is offline is initialized by DeviceInit() when selected.
+void
+Si570ChannelInit(void)
+{
+	uint8_t c;
+
+	for (c = 1; c < SI570_CHANNELS; ++c)
+	{
+		Si570Chan[c-1].Freq    = R.Chan[c-1].Freq;
+		Si570Chan[c-1].OffLine = true;
+		Si570Select(c);
+		DeviceInit();
+	}
+	Si570Select(0);
+}
+
+// Select the Si570 channel for the next commands, an unknown channel
+// is ignored. The cache entries are of a channel, no flush is needed.
+void
+Si570Select(uint8_t channel)
+{
+	if (channel >= SI570_CHANNELS || channel == Si570Channel)
+		return;
+
+	if (Si570Channel != 0)
+		Si570ChannelSwap(Si570Channel);		// Channel 0 back in the globals
+	if (channel != 0)
+		Si570ChannelSwap(channel);
+
+	Si570Channel = channel;
+}
+
+// Copy a 32 bits value (R.Freq, R.FreqXtal) of a channel, the selected
+// channel is not changed.
+void
+Si570ChannelCopy(uint8_t channel, void* dst, const uint32_t* src)
+{
+	uint8_t c = Si570Channel;
+
+	Si570Select(channel);
+	memcpy(dst, src, sizeof(uint32_t));
+	Si570Select(c);
+}
+
+#endif
+
 void
 DeviceInit(void)
 {
 	// Check if Si570 is online and intialize if nessesary
 	// SCL Low is now power on the SI570 chip in the Softrock V9
-	if ((I2C_PIN & _BV(BIT_SCL)) != 0)
+	if (DevicePresent())
 	{
 		if (SI570_OffLine)
 		{
@@ -649,5 +1022,10 @@ Si570WriteLargeChange(void)
 	}
 }
 
+#include "Fsk.c"							// Include code is small size
+#include "Memory.c"							// Include code is small size
+#include "Cal.c"							// Include code is small size
+#include "TempComp.c"						// Include code is small size
+
 #endif
 
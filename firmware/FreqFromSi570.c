@@ -13,8 +13,8 @@
 //**                I like to thank Francis Dupont, F6HSI for some usefull comment!
 //** 
 //** Description..: Calculations the frequency from the Si570 register value.
-//**                The xtal 114.285 will be used as default because that is also
-//**                used in the application.
+//**                The set register command uses the calibrated xtal frequency
+//**                (R.FreqXtal), the registers are the real Si570 registers.
 //**
 //** History......: V15.1 02/12/2008: First release of PE0FKO.
 //**                Check the main.c file
@@ -25,12 +25,11 @@
 
 static
 void
-CalcFreqFromRegSi570(uint8_t* reg)
+CalcFreqFromRegSi570(uint8_t* reg, uint32_t xtal)
 {
 	// As I think about the problem:
 	//  Freq  = xtal * RFREQ / N
-	//  Freq  = 114.285 * RFREQ / N
-	//  20.52 = 8.24    * 12.28 / 16.0
+	//  20.52 = 8.24 * 12.28 / 16.0
 	//  20.52 = 20.52 / 16.0
 	//  19.53 = (20.52 << 1) / 16.0
 	//  19.53 --> 19.21	(remove 4 lowest bytes)
@@ -38,7 +37,7 @@ CalcFreqFromRegSi570(uint8_t* reg)
 	//  19.21 --> 11.21  (remove 1 high byte)
 	//  xxxx.xxxx xxxx.xxxx xxxx.xxxx xxxx.xxxx xxxx.xxxx xxxx.xxxx xxxx.xxxx xxxx.xxxx xxxx.xxxx 
 	//      8         7         6         5         4         3         2         1         0
-	//      A3        A2        A1        A0        B4        B3        B2        B1        B0
+	//      A4        A3        A2        A1        A0        X3        X2        X1        X0
 	//  9876 5432 1098 7654 3210|0123 4567 8901 2345 6789 0
 	//            1098 7654 3210|0123 4567 8901 2345 6789 0
 
@@ -47,18 +46,26 @@ CalcFreqFromRegSi570(uint8_t* reg)
 	//  rewriting, here is what I have understood:
 	//  We need: Freq = F_DCO/N  = xtal*RFREQ /N
 	//  with xtal [8.24] , RFREQ [12.28] and N [16.0]
-	//  F_DCO = xtal*RFREQ is [20.52] (in A3, A2, A1, A0, B4, B3, B2, B1, B0)
+	//  F_DCO = xtal*RFREQ is [20.52] (in A4, A3, A2, A1, A0, X3, X2, X1, X0)
 	//  Then F_DCO <<1 is [19.53]
 	//  as we don't need such resolution we can discard the 4 lower bytes.
-	//  F_DCO is now [19.21] (in A3, A2, A1, A0, B4), so:
+	//  F_DCO is now [19.21] (in A4, A3, A2, A1, A0), so:
 	//  Freq = F_DCO/N is also [19.21], but the first 8 bits are
-	//  always 0, ignore them -> Freq is [11.21] in (A2, A1, A0, B4).
+	//  always 0, ignore them -> Freq is [11.21] in (A3, A2, A1, A0).
+
+	// The multiply and divide are done in one loop pair, without moving
+	// the product out of the registers:
+	//  - The 32 bits xtal is the multiplier, 33 loops in place of 41.
+	//  - The high byte A4 of the DCO is less than N (DCO < 2^13 MHz), it is
+	//    the start remainder of the divide, 33 loops in place of 41.
+	//  - The divide stores the inverted quotient bit, the carry after the
+	//    restore is always set, so no branch to set or clear the carry.
+	//  - The quotient is rounded by the 33th quotient bit.
 
 	uint8_t		cnt;
-	uint8_t		A0,A1,A2,A3,B0,B1,B2,B3,B4;
+	uint8_t		A0,A1,A2,A3,A4,B0,B1,B2,B3,B4;
 	uint8_t		N1,HS_DIV;
 	uint16_t	N;
-//	sint32_t	Freq;
 
 	HS_DIV = (reg[0] >> 5) & 0x07;
 	N1 = ((reg[0] << 2) & 0x7C) | ((reg[1] >> 6) & 0x03);
@@ -67,150 +74,172 @@ CalcFreqFromRegSi570(uint8_t* reg)
 	HS_DIV = HS_DIV + 4;
 	N = HS_DIV * N1;
 
-	A0 = 0;
-	A1 = 0;
-	A2 = 0;
-	A3 = 0;
 	B0 = reg[5];
 	B1 = reg[4];
 	B2 = reg[3];
 	B3 = reg[2];
 	B4 = reg[1] & 0x3F;
 
-	cnt = 40+1;
-
 	asm volatile (
+	"clr %0					\n\t"		// A = 0
+	"clr %1					\n\t"
+	"clr %2					\n\t"
+	"clr %3					\n\t"
+	"clr %4					\n\t"
+	"ldi %11,32+1			\n\t"
 	"clc					\n\t"
 
 "L_A_%=:					\n\t"		// do {
 	"brcc L_B_%=			\n\t"		//   if (C)
 
-	"add %0,%A10			\n\t"		//     A += FreqXtal
-	"adc %1,%B10			\n\t"
-	"adc %2,%C10			\n\t"
-	"adc %3,%D10			\n\t"
+	"add %0,%6				\n\t"		//     A += RFREQ
+	"adc %1,%7				\n\t"
+	"adc %2,%8				\n\t"
+	"adc %3,%9				\n\t"
+	"adc %4,%10				\n\t"
 
-"L_B_%=:					\n\t"		//   C -> A:B -> C
+"L_B_%=:					\n\t"		//   C -> A:X -> C
+	"ror %4					\n\t"
 	"ror %3					\n\t"
 	"ror %2					\n\t"
 	"ror %1					\n\t"
 	"ror %0					\n\t"
 
-	"ror %8					\n\t"
-	"ror %7					\n\t"
-	"ror %6					\n\t"
-	"ror %5					\n\t"
-	"ror %4					\n\t"
+	"ror %D5				\n\t"
+	"ror %C5				\n\t"
+	"ror %B5				\n\t"
+	"ror %A5				\n\t"
 
-	"dec %9					\n\t"		// } while(--cnt != 0);
+	"dec %11				\n\t"		// } while(--cnt != 0);
 	"brne L_A_%=			\n\t"
 
 	// Shift comma one place left, so whe get a
 	// byte boundery for tha actual number.
-	"lsl %7					\n\t"		// A[3-0]:B[4-3] << 1
-	"rol %8					\n\t"
+	"lsl %D5				\n\t"		// A[4-0]:X[3] << 1
 	"rol %0					\n\t"
 	"rol %1					\n\t"
 	"rol %2					\n\t"
 	"rol %3					\n\t"
+	"rol %4					\n\t"
 
-	// Output operand list
-	//--------------------
-	: "=r" (A0)				// %0		A[3-0]:B[4-0] = A[3-0] * B[4-0]
-	, "=r" (A1)				// %1
-	, "=r" (A2)				// %2
-	, "=r" (A3)				// %3
-	, "=r" (B0)				// %4
-	, "=r" (B1)				// %5
-	, "=r" (B2)				// %6
-	, "=r" (B3)				// %7
-	, "=r" (B4)				// %8
-	, "=r" (cnt)			// %9		Loop counter
-
-	// Input operand list
-	//-------------------
-//	: "r" (R.FreqXtal)		// %10		FreqXtal
-	: "r" (DEVICE_XTAL)		// %10		114.285 * _2(24)
-	, "0" (A0)				// 
-	, "1" (A1)				// 
-	, "2" (A2)				// 
-	, "3" (A3)				// 
-	, "4" (B0)				// 			RFREQ[0]
-	, "5" (B1)				// 			RFREQ[1]
-	, "6" (B2)				// 			RFREQ[2]
-	, "7" (B3)				// 			RFREQ[3]
-	, "8" (B4)				// 			RFREQ[4]
-	, "9" (cnt)				// 			Loop counter
-	);
-
-	// A[3-0]:B[4] = A[3-0]:B[4] / N[1-0]
-	// B[1-0] is reminder
-
-	B0 = 0;			// Reminder = 0
-	B1 = 0;
-
-	cnt = 40+1;
-
-	asm volatile (
+	// A[3-0] = A[4-0] / N, remainder in B[1-0]
+	"mov %6,%4				\n\t"		// Remainder = A4
+	"clr %7					\n\t"
+	"ldi %11,32+1			\n\t"
 	"clc					\n\t"
 
-"L_A_%=:					\n\t"		// do {
-	"rol %2					\n\t"		//   C <- A[3-0]:B[4] <- C
+"L_C_%=:					\n\t"		// do {
+	"rol %0					\n\t"		//   C <- A[3-0] <- C
+	"rol %1					\n\t"
+	"rol %2					\n\t"
 	"rol %3					\n\t"
-	"rol %4					\n\t"
-	"rol %5					\n\t"
-	"rol %6					\n\t"
 
-	"rol %0					\n\t"		//   C <- Remainder <- C
-	"rol %1					\n\t"
+	"rol %6					\n\t"		//   C <- Remainder <- C
+	"rol %7					\n\t"
 
-	"sub %0,%A8				\n\t"		//   Remainder =  Remainder - Divisor
-	"sbc %1,%B8				\n\t"
-	
-	"brcc L_B_%=			\n\t"		//   If result negative
-										//   Then
-	"add %0,%A8				\n\t"		//     Restore Remainder
-	"adc %1,%B8				\n\t"
+	"sub %6,%A12			\n\t"		//   Remainder -= N, C = not quotient bit
+	"sbc %7,%B12			\n\t"
 
-	"clc					\n\t"		//     Partial_result = 0
-	"rjmp L_C_%=			\n\t"
+	"brcc L_D_%=			\n\t"		//   If result negative
+	"add %6,%A12			\n\t"		//     Restore Remainder, C = 1
+	"adc %7,%B12			\n\t"
 
-"L_B_%=:					\n\t"		//   Else
-	"sec					\n\t"		//     Partial_result = 1
+"L_D_%=:					\n\t"
+	"dec %11				\n\t"		// } while(--cnt != 0);
+	"brne L_C_%=			\n\t"
 
-"L_C_%=:					\n\t"		//   End If
-	"dec %7					\n\t"		// } while(--cnt == 0)
-	"brne L_A_%=			\n\t"
+	"adc %11,__zero_reg__	\n\t"		// cnt = not the 33th quotient bit
+	"com %0					\n\t"		// A = quotient
+	"com %1					\n\t"
+	"com %2					\n\t"
+	"com %3					\n\t"
+	"subi %11,1				\n\t"		// C = 33th quotient bit
+	"adc %0,__zero_reg__	\n\t"		// Round
+	"adc %1,__zero_reg__	\n\t"
+	"adc %2,__zero_reg__	\n\t"
+	"adc %3,__zero_reg__	\n\t"
 
-"L_X_%=:					\n\t"
 	// Output operand list
 	//--------------------
-	: "=r" (B0)				// %0		Reminder
-	, "=r" (B1)				// %1		Reminder
-//	, "=r" (Freq.b0)		// %2		Frequency
-//	, "=r" (Freq.b1)		// %3		....
-//	, "=r" (Freq.b2)		// %4		....
-//	, "=r" (Freq.b3)		// %5		....
-	, "=r" (reg[0])			// %2		Frequency return in reg[3..0]
-	, "=r" (reg[1])			// %3		....
-	, "=r" (reg[2])			// %4		....
-	, "=r" (reg[3])			// %5		....
-	, "=r" (A3)				// %6		Not used
-	, "=r" (cnt)			// %7		Loop counter
+	: "=&r" (A0)			// %0		A[4-0]:X[3-0] = X[3-0] * B[4-0]
+	, "=&r" (A1)			// %1		A[3-0] = A[4-0] / N
+	, "=&r" (A2)			// %2
+	, "=&r" (A3)			// %3
+	, "=&r" (A4)			// %4
+	, "+r" (xtal)			// %5		FreqXtal, multiplier
+	, "+r" (B0)				// %6		RFREQ[0], Remainder
+	, "+r" (B1)				// %7		RFREQ[1], Remainder
+	, "+r" (B2)				// %8		RFREQ[2]
+	, "+r" (B3)				// %9		RFREQ[3]
+	, "+r" (B4)				// %10		RFREQ[4]
+	, "=&d" (cnt)			// %11		Loop counter
 
 	// Input operand list
 	//-------------------
-	: "r" (N)				// %8		Divisor_16
-	, "0" (B0)				// 			Reminder_16
-	, "1" (B1)				// 			Reminder_16
-	, "2" (B4)				// 			A[3-0]:B[4] = A[3-0]:B[4] / N[1-0]
-	, "3" (A0)				// 			....
-	, "4" (A1)				// 			....
-	, "5" (A2)				// 			....
-	, "6" (A3)				// 			....
-	, "7" (cnt)				// 			Loop counter
+	: "r" (N)				// %12		Divisor_16
 	);
 
-//	SetFreq(Freq.dw, R.Si570_PPM != 0);
+	reg[0] = A0;			// Frequency return in reg[3..0]
+	reg[1] = A1;
+	reg[2] = A2;
+	reg[3] = A3;
+}
+
+
+#if INCLUDE_TUNE_STATUS
+
+typedef struct
+{
+		uint32_t	Freq;					// Achieved Si570 frequency[MHz] (11.21bits)
+		int32_t		Error;					// Achieved - asked frequency[mHz]
+		uint8_t		Path;					// No tune, small or large change
+} tunestat_t;
+
+static	tunestat_t	TuneStat;
+
+// Calculate the achieved frequency and the error of the last tune,
+// from the written HS_DIV, N1, RFREQ and the crystal frequency.
+static void
+CalcTuneStatus(void)
+{
+	uint8_t		reg[sizeof(Si570_t)];
+	uint64_t	rfreq;
+	int64_t		d;
+	uint16_t	N;
+	uint8_t		i;
+
+	memset(&TuneStat, 0, sizeof(TuneStat));
+	if (Si570Tune.Path == TUNE_NONE)
+		return;
+
+	memcpy(reg, &Si570Tune.Reg, sizeof(Si570_t));
+
+	N = (((reg[0] >> 5) & 0x07) + 4) * ((((reg[0] << 2) & 0x7C) | ((reg[1] >> 6) & 0x03)) + 1);
+
+	rfreq = reg[1] & 0x3F;					// RFREQ [12.28]
+	for (i = 2; i < sizeof(Si570_t); ++i)
+		rfreq = (rfreq << 8) | reg[i];
+
+	// DCO error = xtal * RFREQ - freq * N, [44.52] = [8.24] * [12.28] - ([32.32] * N << 20)
+	// Both products overflow 64 bits, but the difference is less than
+	// 2^11 MHz (also after a crystal change) so the wrap around result is exact.
+	d = (int64_t)(rfreq * R.FreqXtal - ((Si570Tune.FreqLO * N) << 20));
+
+	// Error[mHz] = d / N / 2^20 * 10^9 / 2^32, rounded. The product with
+	// 10^9 fits 64 bits below 2^33 (2 MHz), a larger error saturates.
+	d = d / N;
+	d = (d + ((int64_t)1 << 19)) >> 20;
+	if (d >= ((int64_t)1 << 33))
+		TuneStat.Error = INT32_MAX;
+	else
+	if (d <= -((int64_t)1 << 33))
+		TuneStat.Error = INT32_MIN;
+	else
+		TuneStat.Error = (d * 1000000000 + ((int64_t)1 << 31)) >> 32;
+
+	CalcFreqFromRegSi570(reg, R.FreqXtal);
+	memcpy(&TuneStat.Freq, reg, sizeof(uint32_t));
+	TuneStat.Path = Si570Tune.Path;
 }
 
+#endif
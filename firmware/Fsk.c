@@ -0,0 +1,180 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: FSK symbol sequencer (WSPR, FT8, ...) for the Si570.
+//**                The host uploads the base frequency, symbol period,
+//**                tone offset table and the symbols. The firmware plays
+//**                the symbols from the main loop time base and only
+//**                writes the RFREQ registers (smooth tune, no glitch).
+//**                The symbol time is calculated as a 24.8 bits tick
+//**                value, there is no accumulating timing error.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_FSK
+
+		fsk_t		Fsk;					// FSK tables from the host
+static	int32_t		FskDelta[FSK_TONES];	// Tone offset as RFREQ value
+static	Si570_t		FskBase;				// Si570 registers of the base frequency
+static	uint32_t	FskPeriod;				// Symbol period [ticks] (24.8bits)
+static	uint32_t	FskNext;				// Time of the next symbol [ticks] (24.8bits)
+static	uint8_t		FskIndex;				// Next symbol index
+static	uint8_t		FskRun;					// Sequencer running
+
+// Write the base frequency registers plus the RFREQ offset of the tone.
+static void
+FskTone(uint8_t tone)
+{
+	uint8_t*	d = (uint8_t*)&FskDelta[tone];
+	uint8_t		ext = (d[3] & 0x80) ? 0xFF : 0x00;
+	uint16_t	acc = 0;
+	uint8_t		i;
+
+	// 40 bits RFREQ (big endian in Si570_t) plus signed 32 bits delta
+	Si570_Data.bData[0] = FskBase.bData[0];
+	for (i = 0; i < 5; ++i)
+	{
+		acc += FskBase.bData[5-i];
+		acc += (i < 4) ? d[i] : ext;
+		Si570_Data.bData[5-i] = acc;
+		acc >>= 8;
+	}
+
+	Si570WriteSmallChange();
+}
+
+void
+FskStop(void)
+{
+	if (FskRun)
+	{
+		FskRun = false;
+		Si570_Data = FskBase;				// Back to the base frequency
+		Si570WriteSmallChange();
+	}
+}
+
+// Start the sequencer, return false if the tones are out of the smooth
+// tune window or the Si570 is not online.
+uint8_t
+FskStart(void)
+{
+	uint32_t	limit;
+	uint8_t		i;
+	uint8_t		neg;
+#if INCLUDE_IBPF
+	uint8_t		band = GetFreqBand(Fsk.Freq);
+#endif
+
+	FskStop();
+
+	if (Fsk.Symbols > FSK_SYMBOLS || Fsk.Tones > FSK_TONES)
+		return false;
+
+	// Large change to the base frequency, it is the smooth tune center
+	FreqSmoothTune = 0;
+	SetFreq(Fsk.Freq);
+	if (I2CErrors || FreqSmoothTune == 0)
+		return false;
+
+	FskBase = Si570_Data;
+
+	// Max RFREQ change of the smooth tune window, RFREQ * PPM / 10^6
+	// The high 32 bits of the 38 bits RFREQ are used.
+	limit = ((uint32_t)(FskBase.RFREQ_b4 & 0x3F) << 26)
+		  | ((uint32_t)FskBase.RFREQ.w0.b0 << 18)
+		  | ((uint32_t)FskBase.RFREQ.w0.b1 << 10)
+		  | ((uint32_t)FskBase.RFREQ.w1.b0 << 2)
+		  | (FskBase.RFREQ.w1.b1 >> 6);
+	limit = CalcMulDiv(limit, R.SmoothTunePPM, 1000000, 6);
+
+	// RFREQ delta = offset[0.32] * N * 2^20 / FreqXtal[8.24]
+	for (i = 0; i < Fsk.Tones; ++i)
+	{
+		uint32_t off = Fsk.Tone[i];
+		uint32_t delta;
+
+		neg = Fsk.Tone[i] < 0;
+		if (neg)
+			off = -off;
+#if INCLUDE_IBPF
+		if (Si570Channel == 0)				// The band transform is of the LO
+		{
+#if INCLUDE_BAND_RATIO
+			if (R.BandNum[band] != 0)
+			{
+				off = CalcMulDiv(off, R.BandNum[band], R.BandDen[band] & ~BAND_IMAGE, 0);
+				if (R.BandDen[band] & BAND_IMAGE)
+					neg = !neg;				// LO = sub - freq
+			}
+			else
+#endif
+			off = CalcMulDiv(off, R.BandMul[band], _2(21), 0);
+		}
+#endif
+		delta = CalcMulDiv(off, Si570_N, R.FreqXtal, 20);
+		if (delta > limit)
+			return false;
+
+		FskDelta[i] = neg ? -(int32_t)delta : (int32_t)delta;
+	}
+
+	// Period [us] to timer ticks [24.8]: us * F_CPU / 16384 * 256 / 10^6
+	FskPeriod = CalcMulDiv(Fsk.Period, F_CPU / 1000, 64000, 0);
+	FskNext = (uint32_t)TimerTicks << 8;
+	FskIndex = 0;
+	FskRun = true;
+
+	return true;
+}
+
+// Called from the main loop, output the symbol at the symbol time.
+void
+FskPoll(void)
+{
+	uint8_t sym;
+
+	if (!FskRun)
+		return;
+
+	if ((int16_t)(TimerTicks - (uint16_t)(FskNext >> 8)) < 0)
+		return;
+
+	if (FskIndex >= Fsk.Symbols)
+	{
+		FskStop();							// Last symbol time is done
+		return;
+	}
+
+	sym = Fsk.Symbol[FskIndex / 2];
+	if (FskIndex & 1)
+		sym >>= 4;
+	sym &= 0x0F;
+
+	if (sym < Fsk.Tones)
+		FskTone(sym);
+
+	FskIndex += 1;
+	FskNext += FskPeriod;
+}
+
+// Return running status (low byte) and next symbol index (high byte).
+uint16_t
+FskStatus(void)
+{
+	return (FskIndex << 8) | FskRun;
+}
+
+#endif
@@ -0,0 +1,81 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: PCF8574 i2c GPIO expanders on the Si570 i2c bus, for
+//**                the filter and relay selection (command 0x6e, 0x6f).
+//**                The output of each expander is kept in a ram shadow
+//**                register, a write is only send on the i2c bus when
+//**                an output bit is changed.
+//**                Expander 0 is used by the filter banks (RX filter
+//**                low nibble, TX filter high nibble) if switched on.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_GPIO
+
+static	uint8_t		GpioOut[GPIO_CHIPS] = { [0 ... GPIO_CHIPS-1] = 0xFF };	// Output shadow, power up all high
+static	uint8_t		GpioValid;				// Shadow is the output of the expander (bit per chip)
+
+// Change the output bits of the mask, the expander is only written if
+// the output is changed or the last write failed. Returns the output.
+uint8_t
+GpioWrite(uint8_t chip, uint8_t mask, uint8_t data)
+{
+	uint8_t out;
+
+	chip &= GPIO_CHIPS-1;
+	out = (GpioOut[chip] & ~mask) | (data & mask);
+
+	if (out != GpioOut[chip] || !(GpioValid & _BV(chip)))
+	{
+		GpioOut[chip] = out;
+
+		I2CSendStart();
+		I2CSendByte(((GPIO_I2C+chip)<<1)|0);	// send device write address
+		if (I2CErrors == 0)
+			I2CSendByte(out);
+		I2CSendStop();
+
+		if (I2CErrors == 0)
+			GpioValid |= _BV(chip);
+		else
+			GpioValid &= ~_BV(chip);			// Write again on the next change
+	}
+
+	return out;
+}
+
+// Read the input pins of the expander, an output bit that is high
+// can be used as input.
+uint8_t
+GpioRead(uint8_t chip)
+{
+	uint8_t pin = 0xFF;
+
+	chip &= GPIO_CHIPS-1;
+
+	I2CSendStart();
+	I2CSendByte(((GPIO_I2C+chip)<<1)|1);		// send device read address
+	if (I2CErrors == 0)
+	{
+		pin = I2CReceiveByte();
+		I2CSend1();								// 1 Last byte
+	}
+	I2CSendStop();
+
+	return pin;
+}
+
+#endif
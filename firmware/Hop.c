@@ -0,0 +1,124 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: Hardware triggered frequency hop list.
+//**                The host loads a list of frequencies, the Si570
+//**                registers are calculated at load time. Every falling
+//**                edge on the I/O line IO_P1 or IO_P2 will step to the
+//**                next frequency in the list, without any USB command.
+//**                The edge is latched by the pin change interrupt, the
+//**                Si570 is written from the main loop (the i2c is not
+//**                interrupt safe). Only the i2c write time is left.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_HOP
+
+		preset_t	HopList[HOP_MAX];		// Frequency list with the Si570 registers
+static	uint8_t		HopCount;				// Number of frequencies in the list
+static	uint8_t		HopIndex;				// Running list index
+static	uint8_t		HopMask;				// Trigger I/O line, 0 = stopped
+static	uint8_t		HopSave;				// DDR and PORT bit of the trigger line
+static	uint8_t		HopDone;				// Number of handled edges
+static	volatile uint8_t HopEdges;			// Number of edges, counted by the interrupt
+
+ISR(PCINT0_vect, ISR_NOBLOCK)
+{
+	if ((IO_PIN & HopMask) == 0)			// Falling edge only
+		HopEdges += 1;
+}
+
+// Stop the hopping, the I/O line is set back to the old DDR and PORT value.
+static void
+HopStop(void)
+{
+	if (HopMask != 0)
+	{
+		GIMSK &= ~_BV(PCIE);
+		PCMSK = 0;
+
+		if (HopSave & 0x01)
+			IO_DDR |= HopMask;
+		if ((HopSave & 0x02) == 0)
+			IO_PORT &= ~HopMask;
+
+		HopMask = 0;
+	}
+}
+
+// Start the hopping at list index on I/O line 1 (IO_P1) or 2 (IO_P2).
+// The I/O lines are used by the filter if the filter is switched on.
+static uint8_t
+HopStart(uint8_t line, uint8_t index)
+{
+	uint8_t mask;
+
+	HopStop();
+
+#if INCLUDE_ABPF | INCLUDE_IBPF
+	if (FilterCrossOverOn)
+		return false;
+#endif
+
+	if (line == 1)
+		mask = _BV(IO_P1);
+	else
+	if (line == 2)
+		mask = _BV(IO_P2);
+	else
+		return false;
+
+	if (index >= HopCount)
+		return false;
+
+	HopSave = ((IO_DDR & mask) ? 0x01 : 0) | ((IO_PORT & mask) ? 0x02 : 0);
+	IO_DDR  &= ~mask;						// Input with pullup
+	IO_PORT |= mask;
+
+	HopIndex = index;
+	Si570LoadPreset(&HopList[index]);
+
+	HopDone = HopEdges;
+	HopMask = mask;
+	PCMSK = mask;
+	GIFR  = _BV(PCIF);						// No old pending edge
+	GIMSK |= _BV(PCIE);
+
+	return true;
+}
+
+// Called from the main loop, step to the next frequency for every edge.
+static void
+HopPoll(void)
+{
+	while (HopDone != HopEdges)
+	{
+		HopDone += 1;
+
+		if (++HopIndex >= HopCount)
+			HopIndex = 0;
+
+		Si570LoadPreset(&HopList[HopIndex]);
+	}
+}
+
+// Return running status (low byte) and list index (high byte).
+static uint16_t
+HopStatus(void)
+{
+	return (HopIndex << 8) | (HopMask != 0);
+}
+
+#endif
@@ -0,0 +1,210 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: CW keyer, straight key and iambic mode A & B.
+//**                The paddles are the CW key inputs of command 0x51,
+//**                CW Key_1 (PB5) is the dit and CW Key_2 (PB1, i2c SDA)
+//**                the dah paddle. The key output is the I/O line IO_P1
+//**                (PTT). The keyer runs in the main loop on the main
+//**                loop time base, the element times are calculated
+//**                from the start of the element, no timing drift.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_KEYER
+
+#define	KEYER_OFF		0					// Keyer modes
+#define	KEYER_STRAIGHT	1
+#define	KEYER_IAMBIC_A	2
+#define	KEYER_IAMBIC_B	3
+#define	KEYER_MODE		0x03
+#define	KEYER_SWAP		0x80				// Swap dit and dah paddle
+
+#define	KEY_DIT			0x01				// Paddle bits
+#define	KEY_DAH			0x02
+
+#define	KEYER_IDLE		0					// Iambic states
+#define	KEYER_ON		1
+#define	KEYER_SPACE		2
+
+typedef struct
+{
+		uint8_t		Mode;					// Keyer mode                    (wValue low)
+		uint8_t		Wpm;					// Speed [WPM]                   (wValue high)
+		uint8_t		Weight;					// Weight [%], 50 is 1:1 dit:space (wIndex low)
+		uint8_t		Debounce;				// Debounce time [ms]            (wIndex high)
+} keyer_t;
+
+static	keyer_t		Keyer;					// Keyer parameters
+static	uint16_t	KeyerDit;				// Dit key down time [ticks]
+static	uint16_t	KeyerDah;				// Dah key down time [ticks]
+static	uint16_t	KeyerGap;				// Element space time [ticks]
+static	uint8_t		KeyerRaw;				// Last read paddles
+static	uint8_t		KeyerPaddle;			// Debounced paddles
+static	uint16_t	KeyerChange;			// Time of the last paddle change
+static	uint8_t		KeyerState;				// Iambic state
+static	uint8_t		KeyerLast;				// Last send element
+static	uint8_t		KeyerMem;				// Paddle memory, the other element
+static	uint16_t	KeyerTime;				// Start time of the state
+static	uint16_t	KeyerWait;				// Time of the state [ticks]
+
+static void
+KeyerOut(uint8_t key)
+{
+	if (key)
+		PaPttOn();
+	else
+		bit_0(IO_PORT, IO_P1);
+}
+
+// Set the keyer parameters, the filter will use the I/O lines.
+static void
+KeyerSet(usbRequest_t* rq)
+{
+	uint16_t	dit;
+	int16_t		extra;
+
+	memcpy(&Keyer, &rq->wValue, sizeof(Keyer));
+
+#if INCLUDE_ABPF | INCLUDE_IBPF
+	if (FilterCrossOverOn)
+		Keyer.Mode = KEYER_OFF;
+#endif
+
+	if (Keyer.Wpm < 5)  Keyer.Wpm = 5;
+	if (Keyer.Wpm > 60) Keyer.Wpm = 60;
+	if (Keyer.Weight < 25) Keyer.Weight = 25;
+	if (Keyer.Weight > 75) Keyer.Weight = 75;
+
+	// Dit time is 1200ms / WPM (PARIS)
+	dit   = (uint16_t)(1.2 * TIMER_TICK_HZ) / Keyer.Wpm;
+	extra = (int16_t)(dit * (Keyer.Weight - 50)) / 50;
+	KeyerDit = dit + extra;
+	KeyerDah = 3 * dit + extra;
+	KeyerGap = dit - extra;
+
+	KeyerState = KEYER_IDLE;
+	KeyerLast  = 0;
+	KeyerMem   = 0;
+	KeyerOut(0);
+
+	if ((Keyer.Mode & KEYER_MODE) != KEYER_OFF)
+	{
+		bit_1(IO_DDR, IO_P1);
+		bit_0(IO_DDR, IO_P2);				// Dit paddle input with pullup
+		bit_1(IO_PORT, IO_P2);
+	}
+}
+
+// Read the paddles, a paddle is active low.
+static uint8_t
+KeyerRead(void)
+{
+	uint8_t pin = IO_PIN;
+	uint8_t key = 0;
+
+	if ((pin & _BV(IO_P2)) == 0)
+		key |= KEY_DIT;
+	if ((pin & _BV(BIT_SDA)) == 0)
+		key |= KEY_DAH;
+
+	if ((Keyer.Mode & KEYER_SWAP) && key != 0 && key != (KEY_DIT|KEY_DAH))
+		key ^= (KEY_DIT|KEY_DAH);
+
+	return key;
+}
+
+// Called from the main loop.
+static void
+KeyerPoll(void)
+{
+	uint8_t mode = Keyer.Mode & KEYER_MODE;
+	uint8_t paddle;
+
+	if (mode == KEYER_OFF)
+		return;
+
+	// Debounce, the paddles must be stable for the debounce time
+	paddle = KeyerRead();
+	if (paddle != KeyerRaw)
+	{
+		KeyerRaw = paddle;
+		KeyerChange = TimerTicks;
+	}
+	else
+	if ((uint16_t)(TimerTicks - KeyerChange) >= Keyer.Debounce)
+		KeyerPaddle = paddle;
+
+	paddle = KeyerPaddle;
+
+	if (mode == KEYER_STRAIGHT)
+	{
+		KeyerOut(paddle != 0);
+		return;
+	}
+
+	if (KeyerState != KEYER_IDLE)
+	{
+		KeyerMem |= paddle & ~KeyerLast;	// Remember the other paddle
+
+		if ((uint16_t)(TimerTicks - KeyerTime) < KeyerWait)
+			return;
+
+		KeyerTime += KeyerWait;
+
+		if (KeyerState == KEYER_ON)
+		{
+			KeyerOut(0);
+			KeyerState = KEYER_SPACE;
+			KeyerWait  = KeyerGap;
+			return;
+		}
+	}
+	else
+	{
+		KeyerTime = TimerTicks;
+	}
+
+	// Mode A stops after the element when both paddles are released
+	if (mode == KEYER_IAMBIC_A && paddle == 0)
+		KeyerMem = 0;
+
+	paddle |= KeyerMem;
+	KeyerMem = 0;
+
+	if (paddle == (KEY_DIT|KEY_DAH))		// Squeeze, send the other element
+		paddle = (KeyerLast == KEY_DIT) ? KEY_DAH : KEY_DIT;
+
+	KeyerLast = paddle;
+
+	if (paddle == 0)
+	{
+		KeyerState = KEYER_IDLE;
+		return;
+	}
+
+	KeyerOut(1);
+	KeyerState = KEYER_ON;
+	KeyerWait  = (paddle == KEY_DIT) ? KeyerDit : KeyerDah;
+}
+
+// Return the debounced paddles (bit 0 dit, bit 1 dah) and key output (bit 7).
+static uint8_t
+KeyerStatus(void)
+{
+	return KeyerPaddle | ((IO_PORT & _BV(IO_P1)) ? 0x80 : 0);
+}
+
+#endif
@@ -0,0 +1,112 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: Frequency memories in eeprom.
+//**                A memory holds the frequency, filter and the Si570
+//**                registers, calculated when the memory is stored.
+//**                The recall will only write the registers to the Si570,
+//**                the registers are calculated again if the crystal,
+//**                grade or channel is not the one of the store.
+//**                The memories are after the var_t E in eeprom, this file
+//**                is included in DeviceSi570.c (linked after main.c).
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_MEMORY
+
+typedef struct
+{
+		preset_t	P;						// Frequency, filter & registers
+		uint32_t	FreqXtal;				// Crystal of the registers[MHz] (8.24bits)
+#if INCLUDE_SI570_GRADE
+		uint8_t		Grade;					// Si570 grade of the registers
+#endif
+#if INCLUDE_CHANNEL
+		uint8_t		Channel;				// Si570 channel of the registers
+#endif
+} memory_t;
+
+EEMEM	memory_t	Memory[MEMORY_MAX];		// Frequency memories in eeprom
+
+// The memories and the temperature curve must fit in the eeprom after E.
+#if INCLUDE_TEMP_COMP
+typedef	char		memory_eeprom_check[sizeof(var_t) + sizeof(Memory)
+								+ sizeof(TempTable) <= E2END + 1 ? 1 : -1];
+#else
+typedef	char		memory_eeprom_check[sizeof(var_t) + sizeof(Memory) <= E2END + 1 ? 1 : -1];
+#endif
+
+// Store the running frequency in the memory, or clear the memory.
+// Return the stored frequency, 0 is a empty memory.
+uint32_t
+MemoryStore(uint8_t channel, uint8_t clear)
+{
+	memory_t m;
+
+	if (channel >= MEMORY_MAX)
+		return 0;
+
+	if (clear || !Si570CalcPreset(R.Freq, &m.P))
+		m.P.Freq = 0;
+
+	m.FreqXtal = R.FreqXtal;
+#if INCLUDE_SI570_GRADE
+	m.Grade    = R.Si570Grade;
+#endif
+#if INCLUDE_CHANNEL
+	m.Channel  = Si570Channel;
+#endif
+
+	eeprom_write_block(&m, &Memory[channel], sizeof(memory_t));
+
+	return m.P.Freq;
+}
+
+// Read the memory and load it in the Si570 if tune is set. The registers
+// of an other crystal (calibration, temperature), grade or channel are
+// calculated again, the eeprom is not changed.
+// Return the memory frequency, 0 is a empty memory.
+uint32_t
+MemoryRecall(uint8_t channel, uint8_t tune)
+{
+	memory_t m;
+
+	if (channel >= MEMORY_MAX)
+		return 0;
+
+	eeprom_read_block(&m, &Memory[channel], sizeof(memory_t));
+
+	if (m.P.Freq == 0xFFFFFFFF)				// Not initialized eeprom
+		m.P.Freq = 0;
+
+	if (tune && m.P.Freq != 0)
+	{
+		if (m.FreqXtal != R.FreqXtal
+#if INCLUDE_SI570_GRADE
+		||	m.Grade != R.Si570Grade
+#endif
+#if INCLUDE_CHANNEL
+		||	m.Channel != Si570Channel
+#endif
+		)
+			Si570CalcPreset(m.P.Freq, &m.P);
+
+		Si570LoadPreset(&m.P);
+	}
+
+	return m.P.Freq;
+}
+
+#endif
@@ -0,0 +1,85 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: PA protection (command 0x64, 0x66, 0x8a). The values
+//**                of the ADC scanner are checked in the ADC interrupt,
+//**                the temperature against the high temperature limit
+//**                and the reflected power (PB5) against the SWR limit.
+//**                A value over the limit switch the PTT (IO_P1) off
+//**                directly and latch the alarm, the PTT is hold off
+//**                until the host clears the alarm. All the PTT on
+//**                writes (keyer, sequencer, split & commands) go
+//**                through PaPortWrite and are refused by the alarm.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_PA
+
+static	volatile uint8_t PaAlarm;				// Latched alarm bits (1 << ADC channel)
+static	uint16_t	PaTrip[2];				// Value at the trip of ADC_TEMP & ADC_PB5 (12.4bits)
+
+// Check a new scanner value against the limits, called from the ADC
+// interrupt. The limit 0xFFFF is off (the max value is 16 * 1023).
+static void
+PaCheck(uint8_t channel, uint16_t value)
+{
+	uint16_t limit;
+
+	if (channel == ADC_TEMP)
+		limit = R.PaTempLimit;
+	else
+	if (channel == ADC_PB5)
+		limit = R.PaReflLimit;
+	else
+		return;
+
+	if (value >= limit)
+	{
+		bit_0(IO_PORT, IO_P1);				// PTT off
+		if (!(PaAlarm & _BV(channel)))
+			PaTrip[channel] = value;
+		PaAlarm |= _BV(channel);
+	}
+}
+
+// Hold the PTT off while the alarm is latched.
+static void
+PaPoll(void)
+{
+	if (PaAlarm)
+		bit_0(IO_PORT, IO_P1);
+}
+
+// Write the port bits of the mask, the PTT (IO_P1) is kept off while
+// the alarm is latched. The interrupts are off, the ADC interrupt can
+// not latch an alarm between the check and the write.
+static void
+PaPortWrite(uint8_t mask, uint8_t port)
+{
+	cli();
+	port = (IO_PORT & ~mask) | (port & mask);
+	if (PaAlarm)
+		port &= ~_BV(IO_P1);
+	IO_PORT = port;
+	sei();
+}
+
+#else
+
+#define	PaPortWrite(mask, port)	(IO_PORT = (IO_PORT & ~(mask)) | ((port) & (mask)))
+
+#endif
+
+#define	PaPttOn()	PaPortWrite(_BV(IO_P1), _BV(IO_P1))	// PTT on, not with an alarm
@@ -0,0 +1,81 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: Calculate the Si570 registers of a frequency, without
+//**                any i2c write (command 0x3e). The band selection,
+//**                subtract/multiply, divider and RFREQ calculations are
+//**                the same as used by SetFreq. The result is the Si570
+//**                registers, filter, DCO and the achieved frequency.
+//**                A batch of frequencies can be loaded by command 0x7e.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_GET_REGS
+
+typedef struct
+{
+		Si570_t		Reg;					// Si570 register values
+		uint8_t		Filter;					// Filter number (IBPF)
+		uint32_t	Dco;					// DCO frequency[MHz] (16.16bits)
+		uint32_t	Freq;					// Achieved Si570 frequency[MHz] (11.21bits), 0 = error
+} regs_t;
+
+// The batch frequencies are loaded at the end of the result array and
+// calculated in place: result i is written before frequency i+1 is read.
+		regs_t		RegsResult[REGS_BATCH];	// Calculated results
+static	uint8_t		RegsCount;				// Number of results
+#define	RegsFreq	((uint32_t*)((uint8_t*)(RegsResult+REGS_BATCH) - REGS_BATCH*sizeof(uint32_t)))
+
+static void
+RegsCalc(uint32_t freq, regs_t* r)
+{
+	preset_t	p;
+	uint8_t		reg[sizeof(Si570_t)];
+	uint8_t		n1;
+	uint8_t		hs_div;
+	uint16_t	N;
+
+	memset(r, 0, sizeof(regs_t));
+	if (!Si570CalcPreset(freq, &p))
+		return;
+
+	r->Reg = p.Reg;
+#if INCLUDE_IBPF
+	r->Filter = p.Filter;
+#endif
+
+	// Achieved frequency = FreqXtal * RFREQ / N
+	memcpy(reg, &p.Reg, sizeof(Si570_t));
+	CalcFreqFromRegSi570(reg, R.FreqXtal);
+	memcpy(&r->Freq, reg, sizeof(uint32_t));
+
+	// DCO = Freq * N, [16.16] = ([11.5] * N << 11) + ([0.16] * N >> 5)
+	hs_div = p.Reg.HS_DIV + 4;
+	n1     = ((p.Reg.N1 << 2) | (p.Reg.RFREQ_b4 >> 6)) + 1;
+	N      = n1 * hs_div;
+	r->Dco = (((r->Freq >> 16) * N) << 11) + (((r->Freq & 0xFFFF) * N) >> 5);
+}
+
+// Calculate the loaded batch of RegsCount frequencies.
+static void
+RegsBatch(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < RegsCount; ++i)
+		RegsCalc(RegsFreq[i], &RegsResult[i]);
+}
+
+#endif
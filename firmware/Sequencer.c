@@ -0,0 +1,193 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: T/R sequencer, a list of actions with a delay for the
+//**                RX to TX (key down) and TX to RX (key up) switching.
+//**                Actions are: set the I/O lines (PTT, antenna relay),
+//**                set the filter and set the TX or RX frequency.
+//**                The TX and RX frequency are the split frequencies.
+//**                A delay in ms is done in the main loop, a delay in us
+//**                up to 1ms is a busy wait (the USB is not polled), a
+//**                longer us delay is done in the main loop too. A main
+//**                loop delay is rounded up to the time base, never short.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_SEQ
+
+#define	SEQ_END			0					// End of the list
+#define	SEQ_LINE		1					// Set I/O lines, data: line mask (bit 0,1) & level (bit 4,5)
+#define	SEQ_FILTER		2					// Set filter, data: filter number
+#define	SEQ_FREQ		3					// Set split frequency, data: 0 RX, 1 TX
+
+#define	SEQ_DELAY_US	0x8000				// Delay in us, else in ms
+#define	SEQ_US_MAX		1000				// Longest busy wait [us]
+
+#define	SEQ_TRIG_LINE	0x03				// Trigger input I/O line 1 or 2, active low
+#define	SEQ_TRIG_USRP1	0x80				// Trigger by command 0x50
+
+#define	SEQ_RX			0
+#define	SEQ_TX			1
+
+typedef struct
+{
+		uint8_t		Action;					// Action code
+		uint8_t		Data;					// Action data
+		uint16_t	Delay;					// Delay after the action [ms] or [us]
+} seqstep_t;
+
+		seqstep_t	SeqList[2][SEQ_STEPS];	// Key up (RX) & key down (TX) list
+static	uint8_t		SeqTrigger;				// Trigger input
+static	uint8_t		SeqState;				// RX or TX
+static	uint8_t		SeqIndex;				// Next step, SEQ_STEPS is ready
+static	uint16_t	SeqTime;				// Start time of the delay
+static	uint16_t	SeqWait;				// Delay [ticks]
+
+// Busy wait (max SEQ_US_MAX), _delay_loop_2 is 4 clocks for each count.
+static void
+SeqDelayUs(uint16_t us)
+{
+	if (us != 0)
+		_delay_loop_2(((uint32_t)us * (uint16_t)(F_CPU / 4000000.0 * 256)) >> 8);
+}
+
+// Ticks (0.993ms) of a delay, rounded up and one more for the part of
+// the tick that is already gone at the start: at least the delay.
+static uint16_t
+SeqTicks(uint32_t us)
+{
+	return (us + 992) / 993 + 1;
+}
+
+static void
+SeqLine(uint8_t data)
+{
+	if (data & 0x01)
+	{
+		bit_1(IO_DDR, IO_P1);
+		if (data & 0x10)
+			PaPttOn();
+		else
+			bit_0(IO_PORT, IO_P1);
+	}
+	if (data & 0x02)
+	{
+		bit_1(IO_DDR, IO_P2);
+		if (data & 0x20)
+			bit_1(IO_PORT, IO_P2);
+		else
+			bit_0(IO_PORT, IO_P2);
+	}
+}
+
+// Start the RX (key up) or TX (key down) list, a running list is stopped.
+static void
+SeqStart(uint8_t state)
+{
+	SeqState = state;
+	SeqIndex = 0;
+	SeqWait  = 0;
+}
+
+// Set the trigger, the trigger input line is set to input with pullup.
+static void
+SeqSetTrigger(uint8_t trigger)
+{
+	SeqTrigger = trigger;
+
+	if ((trigger & SEQ_TRIG_LINE) == 1)
+	{
+		bit_0(IO_DDR, IO_P1);
+		bit_1(IO_PORT, IO_P1);
+	}
+	else
+	if ((trigger & SEQ_TRIG_LINE) == 2)
+	{
+		bit_0(IO_DDR, IO_P2);
+		bit_1(IO_PORT, IO_P2);
+	}
+}
+
+// Called from the main loop, check the trigger input and run the list.
+static void
+SeqPoll(void)
+{
+	uint8_t line = SeqTrigger & SEQ_TRIG_LINE;
+
+	if (line != 0)
+	{
+		uint8_t tx = (IO_PIN & (line == 1 ? _BV(IO_P1) : _BV(IO_P2))) == 0;
+		if (tx != SeqState)
+			SeqStart(tx);
+	}
+
+	if (SeqIndex >= SEQ_STEPS)
+		return;
+
+	if ((uint16_t)(TimerTicks - SeqTime) < SeqWait)
+		return;
+
+	while (SeqIndex < SEQ_STEPS)
+	{
+		seqstep_t* step = &SeqList[SeqState][SeqIndex++];
+
+		switch (step->Action)
+		{
+		case SEQ_LINE:
+			SeqLine(step->Data);
+			break;
+		case SEQ_FILTER:
+#if INCLUDE_IBPF
+			SetFilter(step->Data);
+#endif
+			break;
+		case SEQ_FREQ:
+			SplitLoad(step->Data & SPLIT_TX);
+			break;
+		default:
+			SeqIndex = SEQ_STEPS;			// End of the list
+			return;
+		}
+
+		if (step->Delay & SEQ_DELAY_US)
+		{
+			uint16_t us = step->Delay & ~SEQ_DELAY_US;
+			if (us <= SEQ_US_MAX)
+				SeqDelayUs(us);
+			else
+			{
+				SeqTime = TimerTicks;
+				SeqWait = SeqTicks(us);
+				return;
+			}
+		}
+		else
+		if (step->Delay != 0)
+		{
+			SeqTime = TimerTicks;
+			SeqWait = SeqTicks(step->Delay * 1000UL);
+			return;
+		}
+	}
+}
+
+// Return TX state (bit 0), list running (bit 7) and the next step (high byte).
+static uint16_t
+SeqStatus(void)
+{
+	return (SeqIndex << 8) | (SeqIndex < SEQ_STEPS ? 0x80 : 0) | SeqState;
+}
+
+#endif
@@ -0,0 +1,77 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: Split (dual VFO) RX and TX frequency.
+//**                The filter and Si570 registers of the RX and TX
+//**                frequency are calculated at load time, the RX/TX
+//**                switch will only write the registers to the Si570.
+//**                If the frequency is changed by an other command
+//**                (0x30, 0x32) in RX, it will be the new RX frequency.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_SPLIT
+
+#define	SPLIT_RX		0
+#define	SPLIT_TX		1
+
+		preset_t	SplitFreq[2];			// RX & TX frequency registers
+static	uint8_t		SplitState;				// RX or TX
+static	uint8_t		SplitOn;				// Command 0x50 will switch the frequency
+
+// Load the RX or TX registers in the Si570.
+static void
+SplitLoad(uint8_t tx)
+{
+	if (SplitState == SPLIT_RX && R.Freq != SplitFreq[SPLIT_RX].Freq)
+		Si570CalcPreset(R.Freq, &SplitFreq[SPLIT_RX]);	// Frequency changed in RX
+
+	SplitState = tx;
+	Si570LoadPreset(&SplitFreq[tx]);
+}
+
+// Set the RX or TX frequency, the running one is loaded in the Si570.
+static void
+SplitSet(uint8_t tx, uint32_t freq)
+{
+	Si570CalcPreset(freq, &SplitFreq[tx]);
+
+	if (tx == SplitState)
+		Si570LoadPreset(&SplitFreq[tx]);
+}
+
+// Switch the PTT (IO_P1) and frequency, TX is set after and RX before
+// the frequency change.
+static void
+SplitPtt(uint8_t tx)
+{
+	if (!tx)
+		bit_0(IO_PORT, IO_P1);
+
+	if (tx != SplitState)
+		SplitLoad(tx);
+
+	if (tx)
+		PaPttOn();
+}
+
+// Return TX state (bit 0) and split on (bit 7).
+static uint8_t
+SplitStatus(void)
+{
+	return SplitState | (SplitOn ? 0x80 : 0);
+}
+
+#endif
@@ -0,0 +1,122 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: Scalar network analyzer, sweep the frequency and sample
+//**                a detector on a free ADC input at every step.
+//**                The detector is connected to PB5 (ADC0) or PB4 (ADC2),
+//**                these pins are not available if the filter (IBPF/ABPF)
+//**                is switched on. The sweep runs in the main loop, so
+//**                the USB stays active while measuring.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_SWEEP
+
+typedef struct
+{
+		uint8_t		Points;					// Number of sweep points        (wValue low)
+		uint8_t		Settle;					// Settle time [ms] before sample (wValue high)
+		uint8_t		Mux;					// ADMUX value, ref and channel  (wIndex low)
+		uint8_t		Samples;				// Log2 of ADC samples per point (wIndex high)
+		uint8_t		Count;					// Points still to measure, 0 = idle
+		uint8_t		Index;					// Number of measured points
+		uint8_t		Tuned;					// Frequency is set, wait settle time
+		uint16_t	Time;					// Time of the frequency set
+		uint32_t	Freq;					// Next frequency [MHz] (11.21bits)
+		uint32_t	Step;					// Step frequency [MHz] (11.21bits, signed)
+		uint32_t	FreqSave;				// Frequency before the sweep
+} sweep_t;
+
+		sweep_t		Sweep;					// Sweep parameters and state
+		uint16_t	SweepData[SWEEP_MAX];	// Detector value (sum of samples)
+
+// Stop a running sweep and restore the frequency from before the sweep.
+static void
+SweepStop(void)
+{
+	if (Sweep.Count != 0)
+	{
+		Sweep.Count = 0;
+		SetFreq(Sweep.FreqSave);
+	}
+}
+
+// Start the sweep, data[0] is the start and data[1] the step frequency.
+// The other parameters are set by the setup (usbFunctionSetup) command.
+static void
+SweepStart(uint32_t* data)
+{
+	Sweep.Index = 0;
+
+#if INCLUDE_ABPF | INCLUDE_IBPF
+	if (FilterCrossOverOn)					// PB4 & PB5 are filter outputs
+		return;
+#endif
+
+	Sweep.Mux &= ~_BV(ADLAR);				// Right adjusted result
+	if ((Sweep.Mux & 0x0D) != 0)			// Only ADC0 (PB5) and ADC2 (PB4)
+		return;
+
+	if (Sweep.Points > SWEEP_MAX)
+		Sweep.Points = SWEEP_MAX;
+
+	if (Sweep.Samples > 6)					// Max 64 samples, fits 16 bits
+		Sweep.Samples = 6;
+
+	// Detector pin input without pull up
+	if (Sweep.Mux & 0x02)
+	{
+		bit_0(IO_DDR, PB4);
+		bit_0(IO_PORT, PB4);
+	}
+	else
+	{
+		bit_0(IO_DDR, PB5);
+		bit_0(IO_PORT, PB5);
+	}
+
+	Sweep.Freq = data[0];
+	Sweep.Step = data[1];
+	Sweep.FreqSave = R.Freq;
+	Sweep.Tuned = false;
+	Sweep.Count = Sweep.Points;
+}
+
+// Called from the main loop, one step of the sweep.
+static void
+SweepPoll(void)
+{
+	if (Sweep.Count == 0)
+		return;
+
+	if (!Sweep.Tuned)
+	{
+		SetFreq(Sweep.Freq);
+		Sweep.Freq += Sweep.Step;
+		Sweep.Time = TimerTicks;
+		Sweep.Tuned = true;
+	}
+	else
+	if ((uint16_t)(TimerTicks - Sweep.Time) > Sweep.Settle)
+	{
+		SweepData[Sweep.Index++] = ReadADC(Sweep.Mux, Sweep.Samples);
+		Sweep.Tuned = false;
+
+		if (--Sweep.Count == 0)
+			SetFreq(Sweep.FreqSave);
+	}
+}
+
+#endif
@@ -0,0 +1,114 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: Temperature compensation of the crystal frequency.
+//**                The chip temperature is read every 0.25 second and
+//**                filtered (time constant 4 seconds). The correction
+//**                of the crystal is interpolated from an eeprom table
+//**                of ppm values at temperature ADC counts of the board.
+//**                If the corrected crystal moves more than the step,
+//**                the Si570 is retuned with the small change (RFREQ).
+//**                Only channel 0 is compensated, there is no retune
+//**                while the FSK symbols are played.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_TEMP_COMP
+
+EEMEM	temppoint_t	TempTable[TEMP_POINTS]	// Compensation curve, sorted by ADC count
+					= { [0 ... TEMP_POINTS-1] = { 0xFFFF, 0 } };
+		uint32_t	TempXtal;				// Crystal frequency without correction, 0 = not set
+		uint16_t	TempFilt;				// Filtered temperature ADC count (12.4bits)
+		int16_t		TempPpm;				// Running correction [0.01 ppm]
+static	uint16_t	TempTicks;				// Time of the last temperature read
+
+// The correction of the temperature, linear between the table points.
+// The unused points at the end of the table are 0xFFFF, outside of the
+// table the first or last point is used.
+static int16_t
+TempCompPpm(uint16_t temp)				// ADC count (12.4bits)
+{
+	temppoint_t	p0, p1;
+	uint8_t		i;
+
+	eeprom_read_block(&p0, &TempTable[0], sizeof(p0));
+	if (p0.Adc == 0xFFFF)					// Empty table
+		return 0;
+
+	if (temp <= (p0.Adc << 4))
+		return p0.Ppm;
+
+	for (i = 1; i < TEMP_POINTS; ++i)
+	{
+		eeprom_read_block(&p1, &TempTable[i], sizeof(p1));
+		if (p1.Adc == 0xFFFF)
+			break;
+
+		if (temp < (p1.Adc << 4))
+			return p0.Ppm + (int32_t)(p1.Ppm - p0.Ppm) * (temp - (p0.Adc << 4))
+							/ (int16_t)((p1.Adc - p0.Adc) << 4);
+		p0 = p1;
+	}
+
+	return p0.Ppm;
+}
+
+// Called from the main loop.
+void
+TempCompPoll(void)
+{
+	uint32_t	xtal;
+	uint32_t	delta;
+
+	if ((uint16_t)(TimerTicks - TempTicks) < TEMP_COMP_TICKS)
+		return;
+	TempTicks = TimerTicks;
+
+	if (TempFilt == 0)
+		TempFilt = GetTemperature() << 4;
+	else
+		TempFilt = TempFilt - (TempFilt >> 4) + GetTemperature();
+
+	if (Si570Channel != 0 || SI570_OffLine)
+		return;
+
+	if (TempXtal == 0)
+		TempXtal = R.FreqXtal;
+
+	// Xtal = Xtal * (1 + ppm / 10^8)
+	TempPpm = TempCompPpm(TempFilt);
+
+#if INCLUDE_FSK
+	if (FskRun)								// The tones are of the running crystal
+		return;
+#endif
+
+	delta = CalcMulDiv(TempXtal, TempPpm < 0 ? -TempPpm : TempPpm, 100000000UL, 0);
+	xtal  = TempPpm < 0 ? TempXtal - delta : TempXtal + delta;
+
+	// Retune if the crystal moved more than the step
+	delta = xtal - R.FreqXtal;
+	if (delta >= _2(31)) delta = 0 - delta;
+	if (delta <= CalcMulDiv(TempXtal, R.TempCompStep, 100000000UL, 0))
+		return;
+
+	R.FreqXtal = xtal;
+#if INCLUDE_CACHE
+	Si570CacheFlush();						// Cached registers are not valid
+#endif
+	DeviceRetune();
+}
+
+#endif
@@ -16,6 +16,118 @@
 
 #include "main.h"
 
+#if (INCLUDE_TEMP & !INCLUDE_ADC_SCAN) | INCLUDE_SWEEP
+
+// Read the ADC input selected by the ADMUX (reference & channel) value.
+// Return the sum of 2^samples conversions (max 2^6 = 64 conversions).
+static uint16_t
+ReadADC(uint8_t mux, uint8_t samples)
+{
+	uint16_t sum = 0;
+	uint8_t n = 1 << samples;
+
+#if INCLUDE_ADC_SCAN
+	AdcScanStop();						// The ADC is used by this read
+#endif
+
+	ADMUX = mux;
+	do {
+		ADCSRA = (1<<ADEN)|(1<<ADSC)|(7<<ADPS0);
+		while(ADCSRA & _BV(ADSC)) {}
+		sum += ADC;
+	} while(--n);
+
+	ADCSRA = (0<<ADEN);
+
+#if INCLUDE_ADC_SCAN
+	AdcScanStart();
+#endif
+
+	return sum;
+}
+
+#endif
+
+#if INCLUDE_ADC_SCAN
+
+// Background ADC scanner, the conversion complete interrupt reads the
+// result and starts the next conversion, no busy wait in the USB handler.
+// The first conversion after a mux / reference change is not used
+// (datasheet: the first result after a reference switch may be inaccurate).
+// The sum of ADC_SAMPLES (16) conversions is the 12.4bits value of the
+// channel, oversampling & decimation gives 2 bits extra resolution.
+// The ADC noise reduction sleep mode can not be used (USB polling), the
+// scanner runs in the ADC clock of prescaler 128 (104us per conversion,
+// 7ms for a scan of all channels).
+
+static const uint8_t AdcMux[ADC_CHANNELS] =
+{
+	(1<<REFS1)|15,						// ADC_TEMP: Ref 1.1V, MUX=ADC4 temperature
+	(0<<REFS1)|0,						// ADC_PB5:  Ref Vcc, ADC0
+	(0<<REFS1)|2,						// ADC_PB4:  Ref Vcc, ADC2
+	(0<<REFS1)|12,						// ADC_VBG:  Ref Vcc, bandgap 1.1V (Vcc = 1.1 * 1024 / ADC)
+};
+
+static	uint16_t	AdcTable[ADC_CHANNELS];	// Last scan values (12.4bits)
+static	uint16_t	AdcSum;
+static	uint8_t		AdcCount;
+static	uint8_t		AdcChan;
+
+ISR(ADC_vect, ISR_NOBLOCK)
+{
+	uint16_t adc = ADC;
+
+	if (AdcCount++ != 0)				// Drop the first conversion of a channel
+		AdcSum += adc;
+
+	if (AdcCount > ADC_SAMPLES)
+	{
+		AdcTable[AdcChan] = AdcSum;
+#if INCLUDE_PA
+		PaCheck(AdcChan, AdcSum);			// PA protection, PTT off directly
+#endif
+		AdcSum = 0;
+		AdcCount = 0;
+		if (++AdcChan >= ADC_CHANNELS)
+			AdcChan = 0;
+		ADMUX = AdcMux[AdcChan];
+	}
+
+	ADCSRA = (1<<ADEN)|(1<<ADSC)|(1<<ADIE)|(7<<ADPS0);
+}
+
+// (Re)start the scan of the current channel, clear a old interrupt flag.
+void
+AdcScanStart(void)
+{
+	AdcSum = 0;
+	AdcCount = 0;
+	ADMUX = AdcMux[AdcChan];
+	ADCSRA = (1<<ADEN)|(1<<ADSC)|(1<<ADIF)|(1<<ADIE)|(7<<ADPS0);
+}
+
+// Stop the scanner, a running conversion is aborted.
+void
+AdcScanStop(void)
+{
+	ADCSRA = (0<<ADEN);
+}
+
+// Read a scan value (12.4bits), the table is written by the interrupt.
+uint16_t
+AdcScanRead(uint8_t channel)
+{
+	uint16_t value;
+
+	cli();
+	value = AdcTable[channel];
+	sei();
+
+	return value;
+}
+
+#endif
+
 #if INCLUDE_TEMP
 
 // Check: Datasheet AVR122
@@ -33,16 +145,14 @@ GetTemperature()
 {
 	uint16_t temp;
 
+#if INCLUDE_ADC_SCAN
+	// The raw count of the scanner value (12.4bits rounded)
+	temp = (AdcScanRead(ADC_TEMP) + 8) >> 4;
+#else
 	// Ref 1.1V, MUX=ADC4 temperature
-	ADMUX = (1<<REFS1)|15;
-	ADCSRA = (1<<ADEN)|(1<<ADSC)|(7<<ADPS0);
-
-	while(ADCSRA & _BV(ADSC)) {}
-
 //	temp = ((ADC - 270) * (6 * (1<<4))) / 7;
-	temp = ADC;	// V15.14 No data conversion anymore!
-
-	ADCSRA = (0<<ADEN);
+	temp = ReadADC((1<<REFS1)|15, 0);	// V15.14 No data conversion anymore!
+#endif
 
 	// Scale to degree centigrade
 //	temp -= 273;
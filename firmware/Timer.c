@@ -0,0 +1,45 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: Free running time base for the main loop functions.
+//**                Timer1 runs at CK/16384 (0.993ms at 16.5MHz) and is
+//**                extended to 16 bits by polling it from the main loop.
+//**                No interrupt is used, the USB interrupt latency is not
+//**                changed. The main loop (watchdog 250ms) is always faster
+//**                than the timer wrap around of 254ms.
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#include "main.h"
+
+#if INCLUDE_TIMER
+
+		uint16_t	TimerTicks;				// Time base [TIMER_TICK_HZ]
+static	uint8_t		TimerLast;				// Last read Timer1 value
+
+static void
+TimerInit(void)
+{
+	TCCR1 = (15<<CS10);						// CK/16384, free running
+}
+
+static void
+TimerPoll(void)
+{
+	uint8_t t = TCNT1;
+
+	TimerTicks += (uint8_t)(t - TimerLast);
+	TimerLast = t;
+}
+
+#endif
@@ -0,0 +1,341 @@
+//************************************************************************
+//**
+//** Project......: Firmware USB AVR Si570 controler.
+//**
+//** Platform.....: ATtiny[48]5 @ 16.5 MHz
+//**
+//** Licence......: This software is freely available for non-commercial
+//**                use - i.e. for research and experimentation only!
+//**
+//** Programmer...: F.W. Krom, PE0FKO
+//**
+//** Description..: The SetFreq pipeline of the oscillator devices: band
+//**                search, filter selection, band transform and the
+//**                small or large change of the device. This file is
+//**                included in the device file and calls the device
+//**                interface functions of that file (see main.h).
+//**
+//** History......: Check the main.c file
+//**
+//**************************************************************************
+
+#if INCLUDE_BAND_CACHE
+static	uint16_t	BandLow;				// Cached band lower bound[MHz] (11.5bits)
+		uint16_t	BandHigh;				// Cached band upper bound[MHz] (11.5bits), 0 = empty
+static	uint8_t		BandCur;				// Cached band number
+#endif
+#if INCLUDE_CAL | INCLUDE_TEMP_COMP
+static	uint32_t	DeviceFreq;				// Device output frequency[MHz] (11.21bits)
+#endif
+#if INCLUDE_TEMP_COMP && INCLUDE_RFREQ_HR
+static	uint64_t	DeviceFreqHR;			// Device output frequency[MHz] (32.32bits), 0 = 11.21 tune
+#endif
+
+#if INCLUDE_IBPF
+
+#if INCLUDE_FILTER_BANK
+
+// Binary search of the band in the sorted cross over points, the number
+// of bands is a power of 2. Band n is from point n-1 up to point n, the
+// unused points at the end of the table must be 0xFFFF.
+static uint8_t
+FilterBandSearch(sint16_t* point, uint8_t bands, uint32_t freq)
+{
+	uint8_t n = 0;
+	sint32_t Freq;
+
+	Freq.dw = freq;
+
+	while (bands >>= 1)
+		if (Freq.w1.w >= point[n + bands - 1].w)
+			n += bands;
+
+	return n;
+}
+
+static uint8_t
+GetFreqBand(uint32_t freq)
+{
+	return FilterBandSearch(R.FilterCrossOver, MAX_BAND, freq);
+}
+
+
+// The TX filter number is the high nibble of the GPIO expander 0, it is
+// only written when the TX filter bank is switched on.
+static void
+SetTxFilter(uint32_t freq)
+{
+	uint8_t band = FilterBandSearch(R.TxCrossOver, TX_BANDS, freq);
+
+	if (TxFilterOn)
+		GpioWrite(0, 0xF0, R.TxBand2Filter[band] << 4);
+}
+
+#else
+
+// The 4 bands are scanned, the first point above the frequency is used,
+// the points of the host tools need not be sorted.
+static uint8_t
+GetFreqBand(uint32_t freq)
+{
+	uint8_t n;
+	sint32_t Freq;
+
+	Freq.dw = freq;
+
+	for(n=0; n < MAX_BAND-1; ++n)
+		if (Freq.w1.w < R.FilterCrossOver[n].w)
+			return n;
+
+	return MAX_BAND-1;
+}
+
+#endif
+
+void
+SetFilter(uint8_t filter)
+{
+	BandCacheClear();						// The filter is not of the cached band
+
+	if (FilterCrossOverOn)
+	{
+#if INCLUDE_FILTER_BANK
+		if (TxFilterOn)
+			GpioWrite(0, 0x0F, filter);		// RX filter, low nibble of expander 0
+#endif
+		bit_1(IO_DDR, IO_P1);
+		bit_1(IO_DDR, IO_P2);
+
+		if (filter & 0x01)
+			bit_1(IO_PORT, IO_P1);
+		else
+			bit_0(IO_PORT, IO_P1);
+
+		if (filter & 0x02)
+			bit_1(IO_PORT, IO_P2);
+		else
+			bit_0(IO_PORT, IO_P2);
+	}
+}
+
+// Get the band of the frequency and set the band filter. A frequency
+// inside the cached band bounds skips the band search and the filter
+// write. The bounds are widened by the hysteresis, tuning around a
+// cross over point does not switch the filter back and forth.
+static uint8_t
+SetFreqBand(uint32_t freq)
+{
+	uint8_t band;
+
+#if INCLUDE_FILTER_BANK
+	SetTxFilter(freq);						// The TX bands have other bounds
+#endif
+
+#if INCLUDE_BAND_CACHE
+	sint32_t Freq;
+	uint16_t hyst = R.FilterHyst;
+
+	Freq.dw = freq;
+	if (Freq.w1.w >= BandLow && Freq.w1.w < BandHigh)
+		return BandCur;
+#endif
+
+	band = GetFreqBand(freq);
+	SetFilter(R.Band2Filter[band]);
+
+#if INCLUDE_BAND_CACHE
+	BandLow  = 0;
+	BandHigh = 0xFFFF;
+	if (band != 0 && R.FilterCrossOver[band-1].w > hyst)
+		BandLow  = R.FilterCrossOver[band-1].w - hyst;
+	if (band != MAX_BAND-1 && R.FilterCrossOver[band].w < 0xFFFF - hyst)
+		BandHigh = R.FilterCrossOver[band].w + hyst;
+	BandCur = band;
+#endif
+
+	return band;
+}
+
+#endif
+
+// Tune the device to the frequency, a small change (smooth tune) if the
+// device can and the frequency is in the window, else a large change.
+static void
+DeviceTune(uint32_t freq)	// frequency [MHz] * 2^21
+{
+	uint8_t		path = TUNE_LARGE;
+
+#if DEVICE_CAPS & DEVICE_CAP_SMOOTH
+	if (DeviceCalcSmall(freq))
+		path = TUNE_SMALL;
+	else
+#endif
+	if (!DeviceCalc(freq))
+		path = TUNE_NONE;
+
+	DeviceTuneSave(freq, path);
+#if INCLUDE_CAL | INCLUDE_TEMP_COMP
+	if (path != TUNE_NONE)
+		DeviceFreq = freq;
+#endif
+#if INCLUDE_TEMP_COMP && INCLUDE_RFREQ_HR
+	if (path != TUNE_NONE)
+		DeviceFreqHR = 0;
+#endif
+
+	if (path == TUNE_SMALL)
+		DeviceWriteSmall();
+	else
+	if (path == TUNE_LARGE)
+		DeviceWriteLarge();
+}
+
+#if INCLUDE_RFREQ_HR
+
+// Tune the device to the high resolution frequency, a device without
+// the high resolution is tuned to the 11.21 frequency.
+static void
+DeviceTuneHR(uint64_t freq)	// frequency [MHz] * 2^32
+{
+	if (freq >= FREQ_HR_MAX)
+		return;
+
+#if DEVICE_CAPS & DEVICE_CAP_HR
+	uint8_t		path = TUNE_LARGE;
+
+#if DEVICE_CAPS & DEVICE_CAP_SMOOTH
+	if (DeviceCalcSmallHR(freq))
+		path = TUNE_SMALL;
+	else
+#endif
+	if (!DeviceCalcHR(freq))
+		path = TUNE_NONE;
+
+	DeviceTuneSaveHR(freq, path);
+#if INCLUDE_CAL | INCLUDE_TEMP_COMP
+	if (path != TUNE_NONE)
+		DeviceFreq = freq >> 11;
+#endif
+#if INCLUDE_TEMP_COMP
+	if (path != TUNE_NONE)
+		DeviceFreqHR = freq;
+#endif
+
+	if (path == TUNE_SMALL)
+		DeviceWriteSmall();
+	else
+	if (path == TUNE_LARGE)
+		DeviceWriteLarge();
+#else
+	DeviceTune(freq >> 11);
+#endif
+}
+
+#endif
+
+void
+SetFreq(uint32_t freq)		// frequency [MHz] * 2^21
+{
+	R.Freq = freq;			// Save the asked freq
+
+#if INCLUDE_IBPF
+
+	if (Si570Channel == 0)	// The bands & transforms are of the LO (channel 0)
+	{
+		uint8_t band = SetFreqBand(freq);
+
+#if INCLUDE_BAND_RATIO
+		if (R.BandNum[band] != 0)
+			freq = CalcFreqRatio(freq, band);
+		else
+#endif
+		if (R.BandSub[band] != 0 || R.BandMul[band] != _2(21))	// Skip (F - 0) * 1.0
+			freq = CalcFreqMulAdd(freq, R.BandSub[band], R.BandMul[band]);
+	}
+
+#endif
+
+//#ifdef INCLUDE_ABPF	<<-- Bug in V15.12
+#if INCLUDE_ABPF
+	if (FilterCrossOverOn)
+	{
+		sint32_t Freq;
+		Freq.dw = R.Freq;			// Freq.w1 is 11.5bits
+
+		bit_1(IO_DDR, IO_P1);
+		bit_1(IO_DDR, IO_P2);
+
+		if (Freq.w1.w < R.FilterCrossOver[0].w)
+		{
+			bit_0(IO_PORT, IO_P1);
+			bit_0(IO_PORT, IO_P2);
+		}
+		else 
+		if (Freq.w1.w < R.FilterCrossOver[1].w)
+		{
+			bit_1(IO_PORT, IO_P1);
+			bit_0(IO_PORT, IO_P2);
+		}
+		else 
+		if (Freq.w1.w < R.FilterCrossOver[2].w)
+		{
+			bit_0(IO_PORT, IO_P1);
+			bit_1(IO_PORT, IO_P2);
+		}
+		else 
+		{
+			bit_1(IO_PORT, IO_P1);
+			bit_1(IO_PORT, IO_P2);
+		}
+	}
+#endif
+
+#if INCLUDE_FREQ_SM
+
+	freq = CalcFreqMulAdd(freq, R.FreqSub, R.FreqMul);
+
+#endif
+
+	DeviceTune(freq);
+}
+
+#if INCLUDE_FREQ_HR
+
+// Set the high resolution frequency, the RFREQ is calculated with all
+// the bits of the frequency. The band, dividers and smooth tune window
+// use the 11.21 frequency. The ABPF filter is not set.
+void
+SetFreqHR(uint64_t freq)	// frequency [MHz] * 2^32
+{
+	if (freq >= FREQ_HR_MAX)
+		return;
+
+	FreqHR = freq;
+	R.Freq = freq >> 11;	// Save the asked freq as 11.21
+
+#if INCLUDE_IBPF
+
+	if (Si570Channel == 0)	// The bands & transforms are of the LO (channel 0)
+	{
+		uint8_t band = SetFreqBand(R.Freq);
+
+#if INCLUDE_BAND_RATIO
+		if (R.BandNum[band] != 0)
+			freq = CalcFreqRatioHR(freq, band);
+		else
+#endif
+		freq = CalcFreqMulAddHR(freq, R.BandSub[band], R.BandMul[band]);
+	}
+
+#endif
+
+#if INCLUDE_FREQ_SM
+
+	freq = CalcFreqMulAddHR(freq, R.FreqSub, R.FreqMul);
+
+#endif
+
+	DeviceTuneHR(freq);
+}
+
+#endif
@@ -64,7 +64,36 @@
 //**                                  RFREQ index. The function CMD_SET_SI570_GRADE (0x44) is extended to
 //**                                  support the change of RFREQ index.
 //**                                  Also removed some global register variables to normal ram.
-//**                                  
+//**               V15.16 18/10/2026: Add a main loop time base (Timer1).
+//**                                  Add cmd 0x70 & 0x71, scalar network analyzer sweep with
+//**                                  the detector on ADC input PB4 or PB5.
+//**                                  Add cmd 0x72 & 0x73, FSK symbol sequencer (WSPR, FT8).
+//**                                  Add cmd 0x74 & 0x75, frequency hop list triggered by
+//**                                  the I/O line IO_P1 or IO_P2.
+//**                                  Add cmd 0x76, CW keyer (straight, iambic A & B).
+//**                                  Add cmd 0x77 & 0x78, T/R sequencer with programmable delays.
+//**                                  Add cmd 0x79 & 0x7a, split RX/TX frequency (precalculated).
+//**                                  The sequencer uses the split RX/TX frequency.
+//**                                  Add cmd 0x7b, LRU cache of the calculated Si570 registers.
+//**                                  Add cmd 0x7c & 0x7d, frequency memories in eeprom.
+//**                                  Add cmd 0x3e & 0x7e, calculate the Si570 registers (batch) without i2c.
+//**                                  Add cmd 0x7f, achieved frequency and error of the last tune.
+//**                                  Add cmd 0x80 & 0x81, high resolution (32.32) frequency.
+//**                                  CalcFreqFromRegSi570() uses the calibrated xtal, faster and rounded.
+//**                                  Add cmd 0x82 & 0x83, per band rational transform (num/den, image).
+//**                                  Add cmd 0x84, band bounds cache with filter cross over hysteresis.
+//**                                  Add cmd 0x1a & 0x1b, 16 band RX & TX filter banks (binary search).
+//**                                  Add cmd 0x6e & 0x6f, PCF8574 GPIO expanders with output shadow.
+//**                                  Add cmd 0x85, multiple Si570 channels (index high byte 0x30..0x3f).
+//**                                  Device interface, SetFreq pipeline of all devices in Vfo.c.
+//**                                  AD9850 DDS device finished, unrolled 40 bits serial load (22us).
+//**                                  Add cmd 0x86, Si5351 device (integer multisynth, CLK0/CLK1 quadrature).
+//**                                  Add cmd 0x87, 1PPS crystal calibration (1PPS IO_P1, prescaled Si570 IO_P2).
+//**                                  Add cmd 0x88 & 0x89, temperature compensation of the crystal (eeprom curve).
+//**                                  Add cmd 0x61, background ADC scanner (temp, PB5, PB4, Vcc, 12.4 bits).
+//**                                  Add cmd 0x64, 0x66 & 0x8a, PA protection (temp & reflected power trip, PTT IO_P1 off).
+//**                                  OSCCAL: verify the stored value on USB reset, track the RC drift (SOF, INCLUDE_OSCCAL_TRACK), eeprom write on change.
+//**
 //**************************************************************************
 //
 //        ATtiny45/85
@@ -163,6 +192,16 @@ EEMEM	var_t		E;									// Variables in eeprom
 #if INCLUDE_SMOOTH
 ,		.SmoothTunePPM		= 3500						// SmoothTunePPM
 #endif
+#if INCLUDE_SI5351
+,		.Si5351Quad			= true						// CLK0 & CLK1 quadrature (SoftRock)
+#endif
+#if INCLUDE_TEMP_COMP
+,		.TempCompStep		= 10						// Retune at 0.1 ppm crystal change
+#endif
+#if INCLUDE_PA
+,		.PaTempLimit		= 0xFFFF					// PA high temperature limit off
+,		.PaReflLimit		= 0xFFFF					// PA reflected power limit off
+#endif
 #if INCLUDE_FREQ_SM
 ,		.FreqSub			= 0.0 * _2(21)				// Freq subtract value is 0.0MHz (11.21bits)
 ,		.FreqMul			= 1.0 * _2(21)				// Freq multiply value os 1.0    (11.21bits)
@@ -171,12 +210,32 @@ EEMEM	var_t		E;									// Variables in eeprom
 ,		.FilterCrossOver[0]	= {  4.0 * 4.0 * _2(5) }	// Default filter cross over
 ,		.FilterCrossOver[1]	= {  8.0 * 4.0 * _2(5) }	// frequnecy for softrock V9
 ,		.FilterCrossOver[2]	= { 16.0 * 4.0 * _2(5) }	// BPF. Four value array.
-,		.FilterCrossOver[3]	= { true }					// ABPF is default enabled
+#if MAX_BAND > 4
+,		.FilterCrossOver[3 ... MAX_BAND-2] = { 0xFFFF }	// Unused bands
+#endif
+,		.FilterCrossOver[MAX_BAND-1] = { true }			// ABPF is default enabled
+#if INCLUDE_BAND_CACHE
+,		.FilterHyst			= 0.0 * 4.0 * _2(5)			// No cross over hysteresis
+#endif
 #endif													// Filter control on/off [3]
+#if INCLUDE_FILTER_BANK
+,		.TxCrossOver[0 ... TX_BANDS-2] = { 0xFFFF }		// Unused bands
+,		.TxCrossOver[TX_BANDS-1] = { false }			// TX filter bank is default disabled
+#endif
 #if INCLUDE_IBPF
 ,		.Band2Filter		= {	0,            1,            2,            3            }
 ,		.BandSub			= {	0.0 * _2(21), 0.0 * _2(21), 0.0 * _2(21), 0.0 * _2(21) }
 ,		.BandMul			= {	1.0 * _2(21), 1.0 * _2(21), 1.0 * _2(21), 1.0 * _2(21) }
+#if MAX_BAND > 4
+,		.BandMul[4 ... MAX_BAND-1] = 1.0 * _2(21)
+#endif
+#endif
+#if INCLUDE_BAND_RATIO
+,		.BandNum			= {	0,            0,            0,            0            }
+,		.BandDen			= {	1,            1,            1,            1            }
+#if MAX_BAND > 4
+,		.BandDen[4 ... MAX_BAND-1] = 1
+#endif
 #endif
 #if INCLUDE_SN
 ,		.SerialNumber		= '0'						// Default USB SerialNumber ID.
@@ -188,6 +247,19 @@ EEMEM	var_t		E;									// Variables in eeprom
 ,		.Si570RFREQIndex	= RFREQ_AUTO_INDEX			// Index for the RFFREQ registers
 #endif
 ,		.ChipCrtlData		= DEVICE_I2C				// I2C address or ChipCrtlData
+#if INCLUDE_CHANNEL
+,		.Chan[0 ... SI570_CHANNELS-2] =					// Channel 1.. same as channel 0
+		{	.FreqXtal			= DEVICE_XTAL
+		,	.Freq				= 0x03866666			// Startup frequency
+#if INCLUDE_SI570_GRADE
+		,	.Si570DCOMin		= DCO_MIN
+		,	.Si570DCOMax		= DCO_MAX
+		,	.Si570Grade			= CHIP_SI570_C
+		,	.Si570RFREQIndex	= RFREQ_AUTO_INDEX
+#endif
+		,	.ChipCrtlData		= DEVICE_I2C			// Set the address by cmd 0x41
+		}
+#endif
 };
 
 
@@ -196,12 +268,28 @@ EEMEM	var_t		E;									// Variables in eeprom
 		uint8_t		SI570_OffLine;				// Si570 offline
 static	uint8_t		bIndex;
 static	uint8_t		usbRequest;					// usbFunctionWrite command
+#if INCLUDE_CHANNEL
+static	uint8_t		usbChannel = SI570_CHANNELS;	// Channel to select again after the command
+#endif
+#if INCLUDE_WRITE_BLOCK
+static	uint8_t*	usbWritePtr;				// usbFunctionWrite block pointer
+static	uint8_t		usbWriteLen;				// usbFunctionWrite block bytes left
+#endif
 
 
 EMPTY_INTERRUPT( __vector_default );			// Redirect all unused interrupts to reti
 
 #include "FreqFromSi570.c"						// Include code is small size
+#include "Regs.c"								// Include code is small size
+#include "Pa.c"								// Include code is small size
 #include "Temperature.c"						// Include code is small size
+#include "Timer.c"								// Include code is small size
+#include "Sweep.c"								// Include code is small size
+#include "Hop.c"								// Include code is small size
+#include "Keyer.c"								// Include code is small size
+#include "Split.c"								// Include code is small size
+#include "Sequencer.c"							// Include code is small size
+#include "Gpio.c"								// Include code is small size
 
 #if INCLUDE_SN
 int	usbDescriptorStringSerialNumber[] = {
@@ -215,13 +303,46 @@ int	usbDescriptorStringSerialNumber[] = {
 /* ------------------------ interface to USB driver ------------------------ */
 /* ------------------------------------------------------------------------- */
 
+#if INCLUDE_CHANNEL
+// Select the channel again after a command to the channel of the index,
+// the selection of command 0x85 is kept.
+static void
+usbChannelRestore(void)
+{
+	Si570Select(usbChannel);				// SI570_CHANNELS is no change
+	usbChannel = SI570_CHANNELS;
+}
+#endif
+
+#if INCLUDE_WRITE_BLOCK
+// Setup the usbFunctionWrite to receive a data block of max size bytes.
+static void
+usbWriteSetup(usbRequest_t* rq, void* ptr, uint8_t size)
+{
+	usbWritePtr = ptr;
+	usbWriteLen = rq->wLength.word < size ? rq->wLength.word : size;
+}
+
+// Receive the data block in chunks of max 8 bytes.
+static uchar
+usbWriteBlock(uchar *data, uchar len)
+{
+	if (len > usbWriteLen)
+		len = usbWriteLen;
+	memcpy(usbWritePtr, data, len);
+	usbWritePtr += len;
+	usbWriteLen -= len;
+	return usbWriteLen == 0;
+}
+#endif
+
 uchar usbFunctionWrite(uchar *data, uchar len) //sends len bytes to SI570
 {
 	SWITCH_START(usbRequest)
 
 	SWITCH_CASE(CMD_SET_FREQ_REG)
 		if (len == sizeof(Si570_t)) {
-			CalcFreqFromRegSi570(data);			// Calc the freq from the Si570 register value
+			CalcFreqFromRegSi570(data, R.FreqXtal);	// Calc the freq from the Si570 register value
 			SetFreq(*(uint32_t*)data);			// and call the SetFreq(..) with the freq!
 		}
 
@@ -252,12 +373,19 @@ uchar usbFunctionWrite(uchar *data, uchar len) //sends len bytes to SI570
 	SWITCH_CASE(CMD_SET_XTAL)					// write new crystal frequency to EEPROM and use it.
 		if (len == sizeof(R.FreqXtal)) {
 			R.FreqXtal = *(uint32_t*)data;
-			eeprom_write_block(data, &E.FreqXtal, sizeof(E.FreqXtal));
+			eeprom_write_block(data, ECHAN(FreqXtal), sizeof(E.FreqXtal));
+#if INCLUDE_TEMP_COMP
+			if (Si570Channel == 0)
+				TempXtal = R.FreqXtal;			// New crystal without correction
+#endif
+#if INCLUDE_CACHE
+			Si570CacheFlush();					// Cached registers are not valid
+#endif
 		}
 
 	SWITCH_CASE(CMD_SET_STARTUP)				// Write new startup frequency to eeprom
 		if (len == sizeof(R.Freq)) {
-			eeprom_write_block(data, &E.Freq, sizeof(E.Freq));
+			eeprom_write_block(data, ECHAN(Freq), sizeof(E.Freq));
 		}
 
 #if  INCLUDE_SMOOTH
@@ -268,8 +396,69 @@ uchar usbFunctionWrite(uchar *data, uchar len) //sends len bytes to SI570
 		}
 #endif
 
+#if  INCLUDE_SWEEP
+	SWITCH_CASE(CMD_SET_SWEEP)					// Start the sweep with the start & step freq
+		if (len == 2*sizeof(uint32_t)) {
+			SweepStart((uint32_t*)data);
+		}
+#endif
+
+#if  INCLUDE_FSK
+	SWITCH_CASE(CMD_SET_FSK)					// Upload the FSK tables
+		return usbWriteBlock(data, len);
+#endif
+
+#if  INCLUDE_HOP
+	SWITCH_CASE(CMD_SET_HOP)					// Calculate the registers of the hop list frequency
+		if (len == sizeof(uint32_t) && bIndex < HOP_MAX) {
+			Si570CalcPreset(*(uint32_t*)data, &HopList[bIndex]);
+		}
+#endif
+
+#if  INCLUDE_SEQ
+	SWITCH_CASE(CMD_SET_SEQ)					// Load the RX or TX list
+		return usbWriteBlock(data, len);
+#endif
+
+#if  INCLUDE_SPLIT
+	SWITCH_CASE(CMD_SET_SPLIT)					// Calculate the registers of the RX or TX frequency
+		if (len == sizeof(uint32_t)) {
+			SplitSet(bIndex & SPLIT_TX, *(uint32_t*)data);
+		}
+#endif
+
+#if  INCLUDE_TEMP_COMP
+	SWITCH_CASE(CMD_SET_TEMP_COMP)				// Write a point (index) of the curve, or the step (index 0xFF)
+		if (len == sizeof(temppoint_t) && bIndex < TEMP_POINTS) {
+			eeprom_write_block(data, &TempTable[bIndex], sizeof(temppoint_t));
+		}
+		else
+		if (len == sizeof(R.TempCompStep) && bIndex == 0xFF) {
+			R.TempCompStep = *(uint16_t*)data;
+			eeprom_write_word(&E.TempCompStep, R.TempCompStep);
+		}
+#endif
+
+#if  INCLUDE_FREQ_HR
+	SWITCH_CASE(CMD_SET_FREQ_HR)				// Set the high resolution frequency and load Si570
+		if (len == sizeof(uint64_t)) {
+			SetFreqHR(*(uint64_t*)data);
+		}
+#endif
+
+#if  INCLUDE_GET_REGS
+	SWITCH_CASE(CMD_SET_REGS)					// Upload the batch, calculate when complete
+		if (!usbWriteBlock(data, len))
+			return 0;
+		RegsBatch();
+#endif
+
 	SWITCH_END
 
+#if INCLUDE_CHANNEL
+	usbChannelRestore();
+#endif
+
 	return 1;
 }
 
@@ -280,6 +469,10 @@ usbFunctionSetup(uchar data[8])
 	usbRequest_t* rq = (usbRequest_t*)data;
 	usbRequest = rq->bRequest;
 
+#if INCLUDE_CHANNEL
+	usbChannelRestore();						// A command without the data
+#endif
+
     usbMsgPtr = (uchar*)replyBuf;
 	replyBuf[0].b0 = 0xff;						// return value 0xff => command not supported 
 
@@ -324,9 +517,9 @@ usbFunctionSetup(uchar data[8])
 		if (!FilterCrossOverOn)
 #endif
 		{
-			IO_PORT = data[2] & 
+			PaPortWrite(0xFF, data[2] & 
 			 ~((1 << USB_CFG_DMINUS_BIT) 
-			 | (1 << USB_CFG_DPLUS_BIT));		// protect USB interface
+			 | (1 << USB_CFG_DPLUS_BIT)));		// protect USB interface
 		}
 		return 0;
 #endif
@@ -345,7 +538,7 @@ usbFunctionSetup(uchar data[8])
 			msk = (rq->wValue.bytes[0] << IO_BIT_START) & (IO_BIT_MASK << IO_BIT_START);
 			dat = (rq->wIndex.bytes[0] << IO_BIT_START) & (IO_BIT_MASK << IO_BIT_START);
 			IO_DDR  = (IO_DDR & ~(IO_BIT_MASK << IO_BIT_START)) | msk;
-			IO_PORT = (IO_PORT & ~msk) | dat;
+			PaPortWrite(msk, dat);
 		}
 		// Return I/O pin's
 		replyBuf[0].w = (IO_PIN>>IO_BIT_START) & IO_BIT_MASK;
@@ -363,7 +556,7 @@ usbFunctionSetup(uchar data[8])
 		if (rq->wIndex.bytes[1] == 0) {
 			// RX Filter cross over point table.
 
-			if (index < 4)
+			if (index < MAX_BAND)
 			{
 				R.FilterCrossOver[index].w = rq->wValue.word;
 
@@ -371,14 +564,29 @@ usbFunctionSetup(uchar data[8])
 						&E.FilterCrossOver[index].w, 
 						sizeof(E.FilterCrossOver[0].w));
 			}
+			BandCacheClear();
 
 			usbMsgPtr = (uint8_t*)&R.FilterCrossOver;
-			return 4 * sizeof(uint16_t);
+			return sizeof(R.FilterCrossOver);
 		}
 		else {
 			// TX Filter cross over point table.
 
+#if INCLUDE_FILTER_BANK
+			if (index < TX_BANDS)
+			{
+				R.TxCrossOver[index].w = rq->wValue.word;
+
+				eeprom_write_block(&R.TxCrossOver[index].w, 
+						&E.TxCrossOver[index].w, 
+						sizeof(E.TxCrossOver[0].w));
+			}
+
+			usbMsgPtr = (uint8_t*)&R.TxCrossOver;
+			return sizeof(R.TxCrossOver);
+#else
 			return 0;
+#endif
 		}
 #endif
 
@@ -402,6 +610,10 @@ usbFunctionSetup(uchar data[8])
 		//	0x34								// Write new startup frequency to eeprom
 		//	0x35								// Write new smooth tune to eeprom and use it.
 		bIndex = rq->wIndex.bytes[0];
+#if INCLUDE_CHANNEL
+		usbChannel = Si570Channel;				// Channel of the freq, registers & xtal
+		Si570Select(Si570IndexChannel(rq->wIndex.bytes[1]));
+#endif
 		return USB_NO_MSG;						// use usbFunctionWrite to transfer data
 
 
@@ -422,7 +634,7 @@ usbFunctionSetup(uchar data[8])
 
 
 	SWITCH_CASE(CMD_GET_FREQ)					// Return running frequnecy
-		usbMsgPtr = (uint8_t*)&R.Freq;
+		Si570ChannelCopy(Si570IndexChannel(rq->wIndex.bytes[1]), replyBuf, &R.Freq);
         return sizeof(uint32_t);
 
 
@@ -434,23 +646,56 @@ usbFunctionSetup(uchar data[8])
 
 
 	SWITCH_CASE(CMD_GET_STARTUP)				// Return the startup frequency
+#if INCLUDE_CHANNEL
+		{
+			uint8_t channel = Si570IndexChannel(rq->wIndex.bytes[1]);
+
+			if (channel != 0 && channel < SI570_CHANNELS)
+			{
+				eeprom_read_block(replyBuf, &E.Chan[channel-1].Freq, sizeof(E.Freq));
+				return sizeof(uint32_t);
+			}
+		}
+#endif
 		eeprom_read_block(replyBuf, &E.Freq, sizeof(E.Freq));
 		return sizeof(uint32_t);
 
 
 	SWITCH_CASE(CMD_GET_XTAL)					// Return the XTal frequnecy
-		usbMsgPtr = (uint8_t*)&R.FreqXtal;
+		Si570ChannelCopy(Si570IndexChannel(rq->wIndex.bytes[1]), replyBuf, &R.FreqXtal);
         return sizeof(uint32_t);
 
 
-//	SWITCH_CASE(CMD_GET_REGS)					// read out calculated frequency control registers
-//		usbMsgPtr = (uint8_t*)&Si570_Data;
-//		return sizeof(Si570_t);
+#if INCLUDE_GET_REGS
+	SWITCH_CASE(CMD_GET_REGS)					// Calculate the registers of freq (value & index), 0 returns the batch
+		if (rq->wValue.word != 0 || rq->wIndex.word != 0)
+		{
+			memcpy(&RegsFreq[0], &rq->wValue, sizeof(uint32_t));
+			RegsCount = 1;
+			RegsBatch();
+		}
+		usbMsgPtr = (uint8_t*)RegsResult;
+		return RegsCount * sizeof(regs_t);
+#endif
 
 
+#if  DEVICE_CAPS & DEVICE_CAP_READ
 	SWITCH_CASE(CMD_GET_SI570)					// read out chip frequency control registers
 		usbMsgPtr = (uint8_t*)&Si570_Data;		// read all registers in one block to Si570_Data
-		return Si570ReadRFREQ(rq->wIndex.bytes[0] != 0 ? rq->wIndex.bytes[0] : R.Si570RFREQIndex );
+#if INCLUDE_CHANNEL
+		{
+			uint8_t channel = Si570Channel;		// Read the channel, keep the selected channel
+			uint8_t n;
+
+			Si570Select(Si570IndexChannel(rq->wIndex.bytes[1]));
+			n = DeviceRead(rq->wIndex.bytes[0] != 0 ? rq->wIndex.bytes[0] : R.Si570RFREQIndex );
+			Si570Select(channel);
+			return n;
+		}
+#else
+		return DeviceRead(rq->wIndex.bytes[0] != 0 ? rq->wIndex.bytes[0] : R.Si570RFREQIndex );
+#endif
+#endif
 
 
 #if  INCLUDE_I2C
@@ -464,17 +709,32 @@ usbFunctionSetup(uchar data[8])
 		replyBuf[0].b0 = R.ChipCrtlData;		// Return the old I2C address (V15.12)
 		if (rq->wValue.bytes[0] != 0) {			// Only set if Value != 0
 			R.ChipCrtlData = rq->wValue.bytes[0];
-			eeprom_write_byte(&E.ChipCrtlData, R.ChipCrtlData);
+			eeprom_write_byte(ECHAN(ChipCrtlData), R.ChipCrtlData);
 		}
 		return sizeof(R.ChipCrtlData);
 
 
 #if INCLUDE_TEMP
 	SWITCH_CASE(CMD_GET_CPU_TEMP)				// Read the temperature mux 0
+#if INCLUDE_ADC_SCAN
+		if (rq->wIndex.bytes[0] == 1)			// V15.16: Scanner value 12.4bits
+			replyBuf[0].w = AdcScanRead(ADC_TEMP);
+		else
+#endif
 		replyBuf[0].w = GetTemperature();
 		return sizeof(uint16_t);
 #endif
 
+#if INCLUDE_ADC_SCAN
+	SWITCH_CASE(CMD_GET_ADC_INPUTS)				// V15.16: Read the ADC scanner table
+	{
+		uint8_t i;
+		for (i = 0; i < ADC_CHANNELS; i++)
+			replyBuf[i].w = AdcScanRead(i);
+		return ADC_CHANNELS * sizeof(uint16_t);
+	}
+#endif
+
 
 #if INCLUDE_SN
 	SWITCH_CASE(CMD_GET_USB_ID)					// Get/Set the USB SeialNumber ID
@@ -489,15 +749,19 @@ usbFunctionSetup(uchar data[8])
 
 #if INCLUDE_SI570_GRADE
 	SWITCH_CASE(CMD_SET_SI570_GRADE)
+#if INCLUDE_CACHE
+		if (rq->wValue.bytes[0] != 0 || rq->wIndex.word != 0)
+			Si570CacheFlush();					// Cached registers are not valid
+#endif
 		if (rq->wValue.bytes[0] != 0) 
 		{
 			// Set Si570 grade (A,B,C) (Option code 3nd)
 			R.Si570Grade = rq->wValue.bytes[0];
-			eeprom_write_byte(&E.Si570Grade, R.Si570Grade);
+			eeprom_write_byte(ECHAN(Si570Grade), R.Si570Grade);
 
 			// Set the RFREQ register index, Option code 2nd
 			R.Si570RFREQIndex = rq->wValue.bytes[1];
-			eeprom_write_byte(&E.Si570RFREQIndex, R.Si570RFREQIndex);
+			eeprom_write_byte(ECHAN(Si570RFREQIndex), R.Si570RFREQIndex);
 
 			SI570_OffLine = true;				// Si570 is offline, not initialized
 			DeviceInit();						// Initialize the Si570 device.
@@ -507,12 +771,12 @@ usbFunctionSetup(uchar data[8])
 			if (rq->wValue.bytes[1] == 0) 
 			{
 				R.Si570DCOMin = rq->wIndex.word;
-				eeprom_write_word(&E.Si570DCOMin, R.Si570DCOMin);
+				eeprom_write_word(ECHAN(Si570DCOMin), R.Si570DCOMin);
 			}
 			else
 			{
 				R.Si570DCOMax = rq->wIndex.word;
-				eeprom_write_word(&E.Si570DCOMax, R.Si570DCOMax);
+				eeprom_write_word(ECHAN(Si570DCOMax), R.Si570DCOMax);
 			}
 		}
 		usbMsgPtr = (uint8_t*)&R.Si570DCOMin;
@@ -526,6 +790,7 @@ usbFunctionSetup(uchar data[8])
 		uint8_t filter = rq->wValue.bytes[0];
 		eeprom_write_byte(&E.Band2Filter[band], filter);
 		R.Band2Filter[band] = filter;
+		BandCacheClear();
 		usbMsgPtr = (uint8_t*)R.Band2Filter;	// Length from 
         return sizeof(R.Band2Filter);
 
@@ -535,24 +800,339 @@ usbFunctionSetup(uchar data[8])
 #endif
 
 
+#if INCLUDE_FILTER_BANK
+	SWITCH_CASE(CMD_SET_TX_BAND_FILTER)			// Set the TX Filters for band 0..15
+		uint8_t band = rq->wIndex.bytes[0] & (TX_BANDS-1);
+		uint8_t filter = rq->wValue.bytes[0] & 0x0F;
+		eeprom_write_byte(&E.TxBand2Filter[band], filter);
+		R.TxBand2Filter[band] = filter;
+		usbMsgPtr = (uint8_t*)R.TxBand2Filter;
+        return sizeof(R.TxBand2Filter);
+
+	SWITCH_CASE(CMD_GET_TX_BAND_FILTER)			// Read the TX Filters for band 0..15
+		usbMsgPtr = (uint8_t*)R.TxBand2Filter;
+        return sizeof(R.TxBand2Filter);
+#endif
+
+
+#if INCLUDE_BAND_RATIO
+	SWITCH_CASE(CMD_SET_BAND_RATIO)				// Set the ratio num (value low) & den (value high) for band 0..3
+		uint8_t band = rq->wIndex.bytes[0] & (MAX_BAND-1);	// 0..3 only
+		uint8_t den = rq->wValue.bytes[1];
+		if ((den & ~BAND_IMAGE) == 0)
+			den |= 1;							// No divide by zero
+		R.BandNum[band] = rq->wValue.bytes[0];
+		R.BandDen[band] = den;
+		eeprom_write_byte(&E.BandNum[band], R.BandNum[band]);
+		eeprom_write_byte(&E.BandDen[band], R.BandDen[band]);
+		usbMsgPtr = (uint8_t*)R.BandNum;		// Num & den of all bands
+		return sizeof(R.BandNum) + sizeof(R.BandDen);
+
+	SWITCH_CASE(CMD_GET_BAND_RATIO)				// Read the ratio num & den for band 0..3
+		usbMsgPtr = (uint8_t*)R.BandNum;		// Num & den of all bands
+		return sizeof(R.BandNum) + sizeof(R.BandDen);
+#endif
+
+
+#if INCLUDE_BAND_CACHE
+	SWITCH_CASE(CMD_SET_FILTER_HYST)			// Read (index 0) or write (index 1) the cross over hysteresis
+		if (rq->wIndex.bytes[0] != 0)
+		{
+			R.FilterHyst = rq->wValue.word;
+			eeprom_write_word(&E.FilterHyst, R.FilterHyst);
+			BandCacheClear();
+		}
+		replyBuf[0].w = R.FilterHyst;
+		return sizeof(uint16_t);
+#endif
+
+
+#if INCLUDE_TEMP_COMP
+	SWITCH_CASE(CMD_SET_TEMP_COMP)				// Write a point of the curve or the step
+		bIndex = rq->wIndex.bytes[0];
+		return USB_NO_MSG;						// use usbFunctionWrite to transfer data
+
+	SWITCH_CASE(CMD_GET_TEMP_COMP)				// Read a point (index) of the curve, or the status (index 0xFF)
+		if (rq->wIndex.bytes[0] < TEMP_POINTS)
+		{
+			eeprom_read_block(replyBuf, &TempTable[rq->wIndex.bytes[0]], sizeof(temppoint_t));
+			return sizeof(temppoint_t);
+		}
+		replyBuf[0].w = TempFilt;				// Filtered temperature (12.4 bits)
+		replyBuf[1].w = TempPpm;				// Running correction [0.01 ppm]
+		replyBuf[2].w = R.TempCompStep;
+		return 3 * sizeof(uint16_t);
+#endif
+
+
+#if INCLUDE_CAL
+	SWITCH_CASE(CMD_RUN_CAL)					// Stop (0) or start (seconds) the 1PPS calibration, index flags
+		if (rq->wValue.bytes[0] == 0)
+			CalStop();
+		else
+		if (rq->wValue.bytes[0] != 0xFF)		// 0xFF only reads the status
+			CalStart(rq->wValue.bytes[0], rq->wIndex.bytes[0]);
+		usbMsgPtr = (uint8_t*)CalStatus();
+		return sizeof(cal_t);
+#endif
+
+
+#if INCLUDE_PA
+	SWITCH_CASE2(CMD_RM_PA_HIGH_TEMP,CMD_RM_PA_SWR)	// Read (index 0) or write (index 1) the PA limit
+	{
+		uint16_t* limit = usbRequest == CMD_RM_PA_HIGH_TEMP ? &R.PaTempLimit : &R.PaReflLimit;
+		if (rq->wIndex.bytes[0] != 0)
+		{
+			*limit = rq->wValue.word;
+			eeprom_write_word(usbRequest == CMD_RM_PA_HIGH_TEMP ? &E.PaTempLimit : &E.PaReflLimit, *limit);
+		}
+		replyBuf[0].w = *limit;
+		return sizeof(uint16_t);
+	}
+
+	SWITCH_CASE(CMD_GET_PA_ALARM)				// Read the latched PA alarm, value 1 clears the alarm
+		replyBuf[0].w = PaAlarm;
+		replyBuf[1].w = PaTrip[ADC_TEMP];
+		replyBuf[2].w = PaTrip[ADC_PB5];
+		if (rq->wValue.bytes[0] == 1)
+			PaAlarm = 0;
+		return 3 * sizeof(uint16_t);
+#endif
+
+
+#if INCLUDE_SI5351
+	SWITCH_CASE(CMD_SET_QUAD)					// Read (index 0) or write (index 1) the Si5351 quadrature
+		if (rq->wIndex.bytes[0] != 0)
+		{
+			R.Si5351Quad = rq->wValue.bytes[0] != 0;
+			eeprom_write_byte(&E.Si5351Quad, R.Si5351Quad);
+
+			SI570_OffLine = true;				// Si5351 is offline, not initialized
+			DeviceInit();						// Initialize the Si5351 device.
+		}
+		replyBuf[0].b0 = R.Si5351Quad;
+		return sizeof(uint8_t);
+#endif
+
+
+#if INCLUDE_GPIO
+	SWITCH_CASE(CMD_SET_BYTE_GPIO)				// Write the bits (value high mask, 0 = all) of expander (index)
+		uint8_t mask = rq->wValue.bytes[1];
+		replyBuf[0].b0 = GpioWrite(rq->wIndex.bytes[0], mask ? mask : 0xFF, rq->wValue.bytes[0]);
+		replyBuf[0].b1 = I2CErrors;
+		return 2 * sizeof(uint8_t);
+
+	SWITCH_CASE(CMD_GET_BYTE_GPIO)				// Read the pins and output of expander (index)
+		replyBuf[0].b0 = GpioRead(rq->wIndex.bytes[0]);
+		replyBuf[0].b1 = GpioOut[rq->wIndex.bytes[0] & (GPIO_CHIPS-1)];
+		return 2 * sizeof(uint8_t);
+#endif
+
+
+#if INCLUDE_CHANNEL
+	SWITCH_CASE(CMD_SET_CHANNEL)				// Select the Si570 channel (value) for the next commands
+		Si570Select(rq->wValue.bytes[0]);
+		replyBuf[0].b0 = Si570Channel;
+		replyBuf[0].b1 = SI570_CHANNELS;
+		return 2 * sizeof(uint8_t);
+#endif
+
+
 	SWITCH_CASE2(CMD_SET_USRP1,CMD_GET_CW_KEY)	// set IO_P1 (cmd=0x50) and read CW key level (cmd=0x50 & 0x51)
+#if  INCLUDE_I2C
 		replyBuf[0].b0 = (_BV(IO_P2) | _BV(BIT_SDA));	// CW Key 1 (PB4) & 2 (PB1 + i2c SDA)
+#else
+		replyBuf[0].b0 = _BV(IO_P2);			// CW Key 1 (PB4), PB1 is the DDS data
+#endif
 #if  INCLUDE_ABPF | INCLUDE_IBPF
 		if (!FilterCrossOverOn)
 #endif
 		{
 			if (usbRequest == 0x50)
 			{
+#if INCLUDE_SEQ
+				if (SeqTrigger & SEQ_TRIG_USRP1)
+				{
+					if ((rq->wValue.bytes[0] != 0) != SeqState)
+						SeqStart(rq->wValue.bytes[0] != 0);
+				}
+				else
+#endif
+#if INCLUDE_SPLIT
+				if (SplitOn)
+					SplitPtt(rq->wValue.bytes[0] != 0);
+				else
+#endif
 			    if (rq->wValue.bytes[0] == 0)
 					bit_0(IO_PORT, IO_P1);
 				else
-					bit_1(IO_PORT, IO_P1);
+					PaPttOn();
 			}
 
 			replyBuf[0].b0 &= IO_PIN;
 		}
         return sizeof(uint8_t);
 
+
+#if INCLUDE_SWEEP
+	SWITCH_CASE(CMD_SET_SWEEP)					// Set the sweep parameters, start & step freq in data
+		SweepStop();
+		memcpy(&Sweep.Points, &rq->wValue, 2*sizeof(uint16_t));
+		return USB_NO_MSG;						// use usbFunctionWrite to transfer data
+
+	SWITCH_CASE(CMD_GET_SWEEP)					// Read the measured detector values from index
+		uint8_t index = rq->wIndex.bytes[0];
+		if (index > Sweep.Index)
+			index = Sweep.Index;
+		usbMsgPtr = (uint8_t*)&SweepData[index];
+		return (Sweep.Index - index) * sizeof(uint16_t);
+#endif
+
+#if INCLUDE_FSK
+	SWITCH_CASE(CMD_SET_FSK)					// Upload FSK tables, index 0: freq, period & tones, 1: symbols
+		FskStop();
+		if (rq->wIndex.bytes[0] == 0)
+		{
+			usbWriteSetup(rq, &Fsk.Freq, 2*sizeof(uint32_t) + sizeof(Fsk.Tone));
+			Fsk.Tones = (usbWriteLen - 2*sizeof(uint32_t)) / sizeof(uint32_t);
+		}
+		else
+		{
+			usbWriteSetup(rq, Fsk.Symbol, sizeof(Fsk.Symbol));
+			Fsk.Symbols = rq->wValue.bytes[0];
+		}
+		return USB_NO_MSG;						// use usbFunctionWrite to transfer data
+
+	SWITCH_CASE(CMD_RUN_FSK)					// Stop (0) or start (1) the FSK sequencer
+		if (rq->wValue.bytes[0] == 0)
+			FskStop();
+		else
+		if (rq->wValue.bytes[0] == 1)
+			FskStart();
+		replyBuf[0].w = FskStatus();			// Running & symbol index
+		return sizeof(uint16_t);
+#endif
+
+
+#if INCLUDE_HOP
+	SWITCH_CASE(CMD_SET_HOP)					// Load frequency index of the hop list, value is list size
+		bIndex = rq->wIndex.bytes[0];
+		HopCount = rq->wValue.bytes[0] < HOP_MAX ? rq->wValue.bytes[0] : HOP_MAX;
+		return USB_NO_MSG;						// use usbFunctionWrite to transfer data
+
+	SWITCH_CASE(CMD_RUN_HOP)					// Stop (0) or start hopping on IO_P1 (1) or IO_P2 (2)
+		if (rq->wValue.bytes[0] == 0)
+			HopStop();
+		else
+		if (rq->wValue.bytes[0] <= 2)
+			HopStart(rq->wValue.bytes[0], rq->wIndex.bytes[0]);
+		replyBuf[0].w = HopStatus();			// Running & list index
+		return sizeof(uint16_t);
+#endif
+
+
+#if INCLUDE_KEYER
+	SWITCH_CASE(CMD_SET_KEYER)					// Set the keyer mode & WPM (value), weight & debounce (index)
+		KeyerSet(rq);
+		replyBuf[0].b0 = KeyerStatus();			// Paddles & key output
+		return sizeof(uint8_t);
+#endif
+
+
+#if INCLUDE_SEQ
+	SWITCH_CASE(CMD_SET_SEQ)					// Load list index 0 (RX) or 1 (TX)
+		bIndex = rq->wIndex.bytes[0];
+		if (bIndex < 2)
+		{
+			memset(SeqList[bIndex], 0, sizeof(SeqList[0]));
+			usbWriteSetup(rq, SeqList[bIndex], sizeof(SeqList[0]));
+		}
+		else
+			usbWriteLen = 0;					// No list, the data is not used
+		return USB_NO_MSG;						// use usbFunctionWrite to transfer data
+
+	SWITCH_CASE(CMD_RUN_SEQ)					// Switch to RX (0) or TX (1), set the trigger (3)
+		if (rq->wValue.bytes[0] <= 1)
+			SeqStart(rq->wValue.bytes[0]);
+		else
+		if (rq->wValue.bytes[0] == 3)
+			SeqSetTrigger(rq->wIndex.bytes[0]);
+		replyBuf[0].w = SeqStatus();			// TX, running & step index
+		return sizeof(uint16_t);
+#endif
+
+
+#if INCLUDE_SPLIT
+	SWITCH_CASE(CMD_SET_SPLIT)					// Set the RX (index 0) or TX (index 1) frequency
+		bIndex = rq->wIndex.bytes[0];
+		return USB_NO_MSG;						// use usbFunctionWrite to transfer data
+
+	SWITCH_CASE(CMD_RUN_SPLIT)					// Switch to RX (0) or TX (1), split off (3) or on (4)
+		if (rq->wValue.bytes[0] <= 1)
+			SplitLoad(rq->wValue.bytes[0]);
+		else
+		if (rq->wValue.bytes[0] == 3)
+			SplitOn = false;
+		else
+		if (rq->wValue.bytes[0] == 4)
+			SplitOn = true;
+		replyBuf[0].b0 = SplitStatus();			// TX & split on
+		return sizeof(uint8_t);
+#endif
+
+
+#if INCLUDE_CACHE
+	SWITCH_CASE(CMD_GET_CACHE)					// Return the cache hits & misses, value 1 will flush the cache
+		replyBuf[0].w = Si570CacheHit;
+		replyBuf[1].w = Si570CacheMiss;
+		if (rq->wValue.bytes[0] == 1)
+		{
+			Si570CacheFlush();
+			Si570CacheHit  = 0;
+			Si570CacheMiss = 0;
+		}
+		return 2 * sizeof(uint16_t);
+#endif
+
+
+#if INCLUDE_MEMORY
+	SWITCH_CASE(CMD_SET_MEMORY)					// Store the running freq in memory (value), index 1 will clear
+		*(uint32_t*)replyBuf = MemoryStore(rq->wValue.bytes[0], rq->wIndex.bytes[0]);
+		return sizeof(uint32_t);
+
+	SWITCH_CASE(CMD_GET_MEMORY)					// Recall memory (value), index 1 will only read the freq
+		*(uint32_t*)replyBuf = MemoryRecall(rq->wValue.bytes[0], rq->wIndex.bytes[0] == 0);
+		return sizeof(uint32_t);
+#endif
+
+
+#if INCLUDE_GET_REGS
+	SWITCH_CASE(CMD_SET_REGS)					// Load a batch of frequencies, read the registers by cmd 0x3e
+		usbWriteSetup(rq, RegsFreq, REGS_BATCH * sizeof(uint32_t));
+		RegsCount = usbWriteLen / sizeof(uint32_t);
+		return USB_NO_MSG;						// use usbFunctionWrite to transfer data
+#endif
+
+
+#if INCLUDE_FREQ_HR
+	SWITCH_CASE(CMD_SET_FREQ_HR)				// Set the high resolution frequency
+		return USB_NO_MSG;						// use usbFunctionWrite to transfer data
+
+	SWITCH_CASE(CMD_GET_FREQ_HR)				// Return the running high resolution frequency
+		if ((uint32_t)(FreqHR >> 11) != R.Freq)	// Set by an other command
+			FreqHR = (uint64_t)R.Freq << 11;
+		usbMsgPtr = (uint8_t*)&FreqHR;
+		return sizeof(uint64_t);
+#endif
+
+
+#if INCLUDE_TUNE_STATUS
+	SWITCH_CASE(CMD_GET_TUNE)					// Return the achieved freq, error & small/large change of the last tune
+		CalcTuneStatus();
+		usbMsgPtr = (uint8_t*)&TuneStat;
+		return sizeof(tunestat_t);
+#endif
+
 	SWITCH_END
 
     return 1;
@@ -593,6 +1173,9 @@ main(void)
 		OSCCAL = R.RC_OSCCAL;
 
 	SI570_OffLine = true;						// Si570 is offline, not initialized
+#if INCLUDE_CHANNEL
+	Si570ChannelInit();							// Initialize the other channels
+#endif
 
 #if INCLUDE_SN
 	// Update the USB SerialNumber string with the correct ID from eprom.
@@ -612,6 +1195,14 @@ main(void)
 
 	usbInit();									// Init the USB used ports
 
+#if INCLUDE_TIMER
+	TimerInit();								// Start the main loop time base
+#endif
+
+#if INCLUDE_ADC_SCAN
+	AdcScanStart();								// Start the background ADC scanner
+#endif
+
 	sei();										// Enable interupts
 
 	while(true)
@@ -619,9 +1210,49 @@ main(void)
 	    wdt_reset();
 	    usbPoll();
 
-#if  INCLUDE_SI570
+#if  INCLUDE_SI570 | INCLUDE_SI5351
 		DeviceInit();
 #endif
+
+#if INCLUDE_TIMER
+		TimerPoll();
+#endif
+
+#if INCLUDE_OSCCAL_TRACK
+		trackOscillator(TimerTicks);			// Follow the RC oscillator drift
+#endif
+
+#if INCLUDE_SWEEP
+		SweepPoll();
+#endif
+
+#if INCLUDE_FSK
+		FskPoll();
+#endif
+
+#if INCLUDE_HOP
+		HopPoll();
+#endif
+
+#if INCLUDE_CAL
+		CalPoll();
+#endif
+
+#if INCLUDE_TEMP_COMP
+		TempCompPoll();
+#endif
+
+#if INCLUDE_PA
+		PaPoll();
+#endif
+
+#if INCLUDE_KEYER
+		KeyerPoll();
+#endif
+
+#if INCLUDE_SEQ
+		SeqPoll();
+#endif
 	}
 }
 
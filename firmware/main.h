@@ -37,18 +37,22 @@
 
 
 #define	VERSION_MAJOR	15
-#define	VERSION_MINOR	15
+#define	VERSION_MINOR	16
 
 
 // Switch's to set the code needed
 #define	INCLUDE_NOT_USED		1			// Compatibility old firmware, I/O functions
 #define	INCLUDE_SI570			1			// Code generation for the PLL Si570 chip
 #define	INCLUDE_AD9850			0			// Code generation for the DDS AD9850 chip
+#define	INCLUDE_SI5351			0			// Code generation for the PLL Si5351 chip
 
 // A costommised USB serial number must be enabled in the usbconfig.h file!
 // Firmware changable USB serial number.
 #define INCLUDE_SN				(USB_CFG_DESCR_PROPS_STRING_SERIAL_NUMBER & USB_PROP_IS_RAM)
 
+// The OSCCAL tracker must be enabled in the usbconfig.h file (INCLUDE_OSCCAL_TRACK),
+// the USB driver counts the SOF packets (USB_COUNT_SOF) for it.
+
 
 #if	INCLUDE_SI570							// Need i2c for the Si570 chip
 #define	DEVICE_XTAL		( 0x7248F5C2 )		// 114.285 * _2(24)
@@ -60,6 +64,26 @@
 #define INCLUDE_SMOOTH			1			// Include automatic smooth tune for the Si570 chip
 #define INCLUDE_TEMP			1			// Include the temperature code
 #define	INCLUDE_SI570_GRADE		1			// Include Si570 Grade select
+#define	INCLUDE_SWEEP			0			// Include the scalar network analyzer sweep (PB4/PB5 ADC input)
+#define	INCLUDE_FSK				0			// Include the FSK (WSPR, FT8) symbol sequencer
+#define	INCLUDE_HOP				0			// Include the frequency hop list (IO_P1/IO_P2 trigger input)
+#define	INCLUDE_KEYER			0			// Include the CW keyer (paddles PB5 & PB1, key output IO_P1)
+#define	INCLUDE_SEQ				0			// Include the T/R sequencer (PTT, relay, filter & TX freq)
+#define	INCLUDE_SPLIT			0			// Include the split (dual VFO) RX and TX frequency
+#define	INCLUDE_CACHE			0			// Include the cache of the calculated Si570 registers
+#define	INCLUDE_MEMORY			0			// Include the frequency memories in eeprom
+#define	INCLUDE_GET_REGS		0			// Include the calculated Si570 registers query (0x3e)
+#define	INCLUDE_TUNE_STATUS		0			// Include the achieved frequency & error of the last tune
+#define	INCLUDE_FREQ_HR			0			// Include the high resolution (32.32) frequency commands
+#define	INCLUDE_BAND_RATIO		0			// Include the per band rational (num/den, image) transform
+#define	INCLUDE_BAND_CACHE		0			// Include the band bounds cache with filter hysteresis
+#define	INCLUDE_FILTER_BANK		0			// Include the 16 band RX & TX filter banks (PCF8574 output)
+#define	INCLUDE_GPIO			0			// Include the PCF8574 i2c GPIO expanders (filters & relays)
+#define	INCLUDE_CHANNEL			0			// Include the multiple Si570 channels on the i2c bus
+#define	INCLUDE_CAL				0			// Include the 1PPS crystal calibration (1PPS IO_P1, count IO_P2)
+#define	INCLUDE_TEMP_COMP		0			// Include the temperature compensation of the crystal
+#define	INCLUDE_ADC_SCAN		0			// Include the background ADC scanner (temp, PB4, PB5, Vcc)
+#define	INCLUDE_PA				0			// Include the PA protection (temp & reflected PB5, PTT IO_P1)
 #endif
 
 
@@ -73,6 +97,18 @@
 #define	INCLUDE_SI570_GRADE		0			// Include Si570 Grade select
 #endif
 
+#if	INCLUDE_SI5351							// Code generation for the PLL Si5351 chip
+#define	DEVICE_XTAL		( 0x19000000 )		// 25.000 * _2(24)
+#define	DEVICE_I2C		( 0x60 )			// Default Si5351 I2C address
+#define	INCLUDE_I2C				1			// Include the i2c code
+#define	INCLUDE_IBPF			1			// Include inteligent band-pass-filter code.
+#define	INCLUDE_ABPF			0			// Include automatic band pass filter selection
+#define	INCLUDE_FREQ_SM			0			// Include frequency subtract multiply values
+#define	INCLUDE_SMOOTH			0			// The Si5351 small change is the PLL range, no ppm
+#define	INCLUDE_TEMP			1			// Include the temperature code
+#define	INCLUDE_SI570_GRADE		0			// Include Si570 Grade select
+#endif
+
 #if INCLUDE_IBPF
 #undef	INCLUDE_ABPF
 #define	INCLUDE_ABPF			0			// ABPF is part of the new IBPF
@@ -80,6 +116,121 @@
 #define	INCLUDE_FREQ_SM			0			// Freq offset/multiply is part of the new IBPF
 #endif
 
+#if !INCLUDE_IBPF
+#undef	INCLUDE_BAND_RATIO
+#define	INCLUDE_BAND_RATIO		0			// The band ratio is part of the IBPF
+#undef	INCLUDE_BAND_CACHE
+#define	INCLUDE_BAND_CACHE		0			// The band cache is part of the IBPF
+#undef	INCLUDE_FILTER_BANK
+#define	INCLUDE_FILTER_BANK		0			// The filter banks are part of the IBPF
+#endif
+
+#if INCLUDE_CAL
+#undef	INCLUDE_HOP
+#define	INCLUDE_HOP				0			// The pin change interrupt is used by the calibration
+#endif
+
+#if !INCLUDE_SI570
+#undef	INCLUDE_FSK
+#define	INCLUDE_FSK				0			// The FSK tones are Si570 RFREQ steps
+#endif
+
+#if INCLUDE_FSK
+#undef	INCLUDE_SMOOTH
+#define	INCLUDE_SMOOTH			1			// The FSK tones stay in the smooth tune window
+#endif
+
+#if INCLUDE_TEMP_COMP
+#define	TEMP_POINTS				8			// Points of the compensation curve (4 bytes eeprom each)
+#define	TEMP_COMP_TICKS			256			// Temperature read interval (0.25s)
+#undef	INCLUDE_TEMP
+#define	INCLUDE_TEMP			1			// The compensation reads the temperature
+#endif
+
+#if INCLUDE_PA
+#undef	INCLUDE_ADC_SCAN
+#define	INCLUDE_ADC_SCAN		1			// The PA protection checks the scanner values
+#endif
+
+#if INCLUDE_ADC_SCAN
+#define	ADC_CHANNELS			4			// Temperature, PB5, PB4 & Vcc (bandgap)
+#define	ADC_SAMPLES				16			// Conversions per value, 12.4bits
+#undef	INCLUDE_TEMP
+#define	INCLUDE_TEMP			1			// The temperature is read by the scanner
+#endif
+
+#if INCLUDE_FILTER_BANK
+#define	MAX_BAND				16			// RX bands, power of 2 (11 bytes ram each, 13 with BAND_RATIO)
+#if INCLUDE_BAND_RATIO
+#define	TX_BANDS				8			// TX bands, the ram check (var_t) fails with 16
+#else
+#define	TX_BANDS				16			// TX bands, power of 2 (3 bytes ram each)
+#endif
+#undef	INCLUDE_GPIO
+#define	INCLUDE_GPIO			1			// Filter banks use the GPIO expander 0
+#endif
+
+#if INCLUDE_CHANNEL
+#define	SI570_CHANNELS			3			// Si570 channels, LO BFO & TX (35 bytes ram each extra)
+#endif
+
+#if INCLUDE_GPIO
+#define	GPIO_CHIPS				2			// PCF8574 expanders, power of 2 (1 byte ram each)
+#define	GPIO_I2C				0x20		// i2c address of the first expander (A2..A0 = 0)
+#endif
+
+#if INCLUDE_SWEEP
+#define	SWEEP_MAX				64			// Max sweep points (2 bytes ram each)
+#endif
+
+#if INCLUDE_FSK
+#define	FSK_TONES				8			// Max FSK tones (4 bytes ram each, twice)
+#define	FSK_SYMBOLS				162			// Max FSK symbols (2 symbols per byte ram)
+#endif
+
+#if INCLUDE_HOP
+#define	HOP_MAX					8			// Max frequencies in the hop list (15 bytes ram each)
+#endif
+
+#if INCLUDE_SEQ
+#define	SEQ_STEPS				6			// Max steps in the RX and TX list (4 bytes ram each)
+#undef	INCLUDE_SPLIT
+#define	INCLUDE_SPLIT			1			// Sequencer uses the split RX and TX frequency
+#endif
+
+#if INCLUDE_CACHE
+#define	CACHE_SIZE				8			// Cache entries (10 bytes ram each)
+#endif
+
+#if INCLUDE_MEMORY
+#if E2END < 0x1FF
+#define	MEMORY_MAX				6			// Frequency memories (20 bytes eeprom each), 256 bytes eeprom
+#elif INCLUDE_FILTER_BANK
+#define	MEMORY_MAX				8			// Frequency memories, the filter banks use half of the eeprom
+#else
+#define	MEMORY_MAX				16			// Frequency memories (20 bytes eeprom each)
+#endif
+#endif
+
+#if INCLUDE_GET_REGS
+#define	REGS_BATCH				8			// Max frequencies in a batch (15 bytes ram each)
+#endif
+
+// The precalculated Si570 register sets
+#define	INCLUDE_PRESET			(INCLUDE_HOP | INCLUDE_SPLIT | INCLUDE_MEMORY | INCLUDE_GET_REGS)
+
+// The main loop time base is needed for the timed functions
+#define	INCLUDE_TIMER			(INCLUDE_SWEEP | INCLUDE_FSK | INCLUDE_KEYER | INCLUDE_SEQ | INCLUDE_TEMP_COMP | INCLUDE_OSCCAL_TRACK)
+
+// The 64 bits multiply divide function
+#define	INCLUDE_MULDIV			(INCLUDE_FSK | INCLUDE_FREQ_HR | INCLUDE_CAL | INCLUDE_TEMP_COMP | INCLUDE_SI5351)
+
+// The high resolution RFREQ calculation
+#define	INCLUDE_RFREQ_HR		INCLUDE_FREQ_HR
+
+// The usbFunctionWrite for data blocks larger than 8 bytes
+#define	INCLUDE_WRITE_BLOCK		(INCLUDE_FSK | INCLUDE_SEQ | INCLUDE_GET_REGS)
+
 
 #define IO_DDR			DDRB
 #define IO_PORT			PORTB
@@ -103,6 +254,7 @@
 #define	DDS_DATA		PB1
 #define	DDS_W_CLK		PB3
 #define	DDS_FQ_UD		PB4
+#define	DDS_DDR			DDRB
 #endif
 
 #define	true			1
@@ -113,7 +265,10 @@
 #define	bit_1(port,bit)	port |= _BV(bit)	// Set bit to one
 #define	bit_0(port,bit)	port &= ~_BV(bit)	// Set bit to zero
 
-#define	MAX_BAND		(_2(IO_BIT_LENGTH))	// Max of 4 band's
+#ifndef	MAX_BAND
+#define	MAX_BAND		(1<<IO_BIT_LENGTH)	// Max of 4 band's
+#endif
+#define	BAND_IMAGE		0x80				// Band ratio image, LO = (sub - freq) * num / den
 
 
 typedef union {
@@ -143,6 +298,21 @@ typedef union {
 	};
 } Si570_t;
 
+#if INCLUDE_CHANNEL
+typedef struct
+{
+		uint32_t	FreqXtal;				// crystal frequency[MHz] (8.24bits)
+		uint32_t	Freq;					// Startup frequency[MHz] (11.21bits)
+#if INCLUDE_SI570_GRADE
+		uint16_t	Si570DCOMin;			// Si570 Minimal DCO value
+		uint16_t	Si570DCOMax;			// Si570 Maximal DCO value
+		uint8_t		Si570Grade;				// Si570 chip grade
+		uint8_t		Si570RFREQIndex;		// Index to be used for the RFFREQ registers & freeze
+#endif
+		uint8_t		ChipCrtlData;			// I2C addres
+} chancfg_t;
+#endif
+
 typedef struct 
 {
 		uint8_t		RC_OSCCAL;				// CPU osc tune value
@@ -151,17 +321,38 @@ typedef struct
 #if INCLUDE_SMOOTH
 		uint16_t	SmoothTunePPM;			// Max PPM value for the smooth tune
 #endif
+#if INCLUDE_SI5351
+		uint8_t		Si5351Quad;				// CLK0 & CLK1 in quadrature at freq / 4
+#endif
+#if INCLUDE_TEMP_COMP
+		uint16_t	TempCompStep;			// Retune step of the crystal correction [0.01 ppm]
+#endif
+#if INCLUDE_PA
+		uint16_t	PaTempLimit;			// PA high temperature limit, scanner ADC count (12.4bits)
+		uint16_t	PaReflLimit;			// PA reflected power (PB5) limit, scanner ADC count (12.4bits)
+#endif
 #if INCLUDE_FREQ_SM
 		uint32_t	FreqSub;				// Freq subtract value[MHz] (11.21bits)
 		uint32_t	FreqMul;				// Freq multiply value (11.21bits)
 #endif
 #if INCLUDE_ABPF | INCLUDE_IBPF
 		sint16_t	FilterCrossOver[MAX_BAND];// Filter cross over points [0..2] (11.5bits)
+#if INCLUDE_BAND_CACHE
+		uint16_t	FilterHyst;				// Filter cross over hysteresis[MHz] (11.5bits)
+#endif
 #endif										// Filter control on/off [3]
+#if INCLUDE_FILTER_BANK
+		sint16_t	TxCrossOver[TX_BANDS];	// TX filter cross over points [0..14] (11.5bits)
+		uint8_t		TxBand2Filter[TX_BANDS];// TX filter number for band 0..15
+#endif										// TX filter control on/off [15]
 #if INCLUDE_IBPF
 		uint8_t		Band2Filter[MAX_BAND];	// Filter number for band 0..3
 		uint32_t	BandSub[MAX_BAND];		// Freq subtract value[MHz] (11.21bits) for band 0..3
 		uint32_t	BandMul[MAX_BAND];		// Freq multiply value (11.21bits) for band 0..3
+#if INCLUDE_BAND_RATIO
+		uint8_t		BandNum[MAX_BAND];		// Freq multiply numerator for band 0..3, 0 = use BandMul
+		uint8_t		BandDen[MAX_BAND];		// Freq multiply denominator & BAND_IMAGE for band 0..3
+#endif
 #endif										// Filter control on/off [3]
 #if INCLUDE_SN
 		uint8_t		SerialNumber;			// Default serial number last char! ("PE0FKO-2.0")
@@ -173,10 +364,21 @@ typedef struct
 		uint8_t		Si570RFREQIndex;		// [0..6bit]Index to be used for the RFFREQ registers (7-12, 13-18), [7bit] Use freeze RFREQ register
 #endif
 		uint8_t		ChipCrtlData;			// I2C addres, default 0x55 (85 dec)
+#if INCLUDE_CHANNEL
+		chancfg_t	Chan[SI570_CHANNELS-1];	// Config of channel 1.. (swapped with the above)
+#endif
 
 } var_t;
 
+// The ram copy R of the eeprom variables may use max half of the SRAM,
+// the other half is for the USB driver, the stack and the other features.
+// The 16 band filter banks use 224 bytes (232 with BAND_RATIO and 8 TX
+// bands), if this check fails use 8 bands for MAX_BAND and / or TX_BANDS.
+#define	VAR_RAM_MAX		((RAMEND - 0x5F) / 2)
+typedef	char		var_ram_check[sizeof(var_t) <= VAR_RAM_MAX ? 1 : -1];
 
+
+extern	var_t		E;						// Variables in eeprom
 extern	var_t		R;						// Variables in Ram
 extern	sint16_t	replyBuf[4];			// USB Reply buffer
 extern	Si570_t		Si570_Data;				// Registers 7..12 value for the Si570
@@ -186,6 +388,50 @@ extern	uint8_t		Si570ReadRFREQ(uint8_t index);
 extern	void		SetFreq(uint32_t freq);
 extern	void		DeviceInit(void);
 
+// Oscillator device interface. The device file (DeviceSi570.c) has the
+// functions below and includes the SetFreq pipeline of Vfo.c, that one
+// calls them. The device is selected at compile time, there are no
+// function pointers (flash and ram of the ATtiny).
+//   DeviceInit()			Init the device if it is (again) present
+//   DevicePresent()		The device is powered and on the bus
+//   DeviceCalc(freq)		Calculate the registers of a large change
+//   DeviceCalcSmall(freq)	Calculate a small change, false if outside window
+//   DeviceCalcHR(freq)		Calculate a large change of the 32.32 frequency
+//   DeviceCalcSmallHR(freq)	Calculate a small change of the 32.32 frequency
+//   DeviceWriteSmall()		Write the small change to the device
+//   DeviceWriteLarge()		Write the large change to the device
+//   DeviceTuneSave(freq,path)	Save the tune status
+//   DeviceRead(index)		Read back the registers in Si570_Data
+//   DeviceRetune()		Retune after a crystal change (small change)
+#define	DEVICE_CAP_SMOOTH		0x01		// DeviceCalcSmall, small change possible
+#define	DEVICE_CAP_READ			0x02		// DeviceRead, registers can be read back
+#define	DEVICE_CAP_HR			0x04		// DeviceCalcHR, high resolution frequency
+
+#if INCLUDE_SI570
+#define	DEVICE_CAPS		((INCLUDE_SMOOTH ? DEVICE_CAP_SMOOTH : 0) | DEVICE_CAP_READ | (INCLUDE_RFREQ_HR ? DEVICE_CAP_HR : 0))
+#define	DeviceRead(index)		Si570ReadRFREQ(index)
+#elif INCLUDE_SI5351
+#define	DEVICE_CAPS				DEVICE_CAP_SMOOTH
+#else
+#define	DEVICE_CAPS				0
+#endif
+
+#if INCLUDE_CHANNEL
+extern	uint8_t		Si570Channel;			// Selected Si570 channel
+extern	void		Si570ChannelInit(void);
+extern	void		Si570Select(uint8_t channel);
+extern	void		Si570ChannelCopy(uint8_t channel, void* dst, const uint32_t* src);
+#define	CHANNEL_INDEX			0x80		// Index high byte 0x80 | channel, else the selected channel
+#define	Si570IndexChannel(b)	((b) & CHANNEL_INDEX ? (b) & ~CHANNEL_INDEX : Si570Channel)
+#define	ECHAN(f)	(Si570Channel == 0 ? &E.f : &E.Chan[Si570Channel-1].f)	// Eeprom of the channel config
+#else
+#define	ECHAN(f)	(&E.f)
+#define	Si570Channel			0
+#define	Si570Select(channel)
+#define	Si570IndexChannel(b)	0
+#define	Si570ChannelCopy(channel, dst, src)	memcpy(dst, src, sizeof(uint32_t))
+#endif
+
 #if INCLUDE_SI570
 
 #define	DCO_MIN		4850					// min VCO frequency 4850 MHz
@@ -212,16 +458,171 @@ extern	void		DeviceInit(void);
 #define	RFREQ_FREEZE			0x80
 
 extern	void		Si570CmdReg(uint8_t reg, uint8_t data);
+#endif
+
+#if INCLUDE_SI5351
+#define	PLL_MIN		600						// min VCO frequency 600 MHz
+#define	PLL_MAX		900						// max VCO frequency 900 MHz
+#define	SI5351_PHASE_MAX		126			// Max divider of the 90 degree phase offset (7 bits)
 #endif
 
 #if INCLUDE_SMOOTH
 extern	uint32_t	FreqSmoothTune;			// The smooth tune center frequency
 #endif
 
+#if INCLUDE_PRESET
+typedef struct
+{
+		uint32_t	Freq;					// Frequency[MHz] (11.21bits), 0 = not valid
+		uint32_t	FreqLO;					// Si570 frequency[MHz] (11.21bits)
+		Si570_t		Reg;					// Si570 register values
+#if INCLUDE_IBPF
+		uint8_t		Filter;					// Filter number
+#endif
+} preset_t;
+
+extern	uint8_t		Si570CalcPreset(uint32_t freq, preset_t* p);
+extern	void		Si570LoadPreset(preset_t* p);
+#endif
+
+#if INCLUDE_CACHE
+extern	uint16_t	Si570CacheHit;			// Number of cache hits
+extern	uint16_t	Si570CacheMiss;			// Number of cache misses
+extern	void		Si570CacheFlush(void);
+#endif
+
+#if INCLUDE_MEMORY
+extern	uint32_t	MemoryStore(uint8_t channel, uint8_t clear);
+extern	uint32_t	MemoryRecall(uint8_t channel, uint8_t tune);
+#endif
+
+#define	TUNE_NONE				0			// No tune, the calculation failed
+#define	TUNE_SMALL				1			// Small change, only RFREQ written
+#define	TUNE_LARGE				2			// Large change, dividers & RFREQ written
+
+#if INCLUDE_TUNE_STATUS
+typedef struct
+{
+		uint64_t	FreqLO;					// Asked Si570 frequency[MHz] (32.32bits)
+		Si570_t		Reg;					// Written Si570 register values
+		uint8_t		Path;					// Small or large change
+} tune_t;
+
+extern	tune_t		Si570Tune;				// Last tune of the Si570
+#endif
+
+#if INCLUDE_RFREQ_HR
+#define	FREQ_HR_MAX		((uint64_t)1<<43)	// 2048 MHz, the range of the 11.21 frequency
+#endif
+
+#if INCLUDE_FREQ_HR
+extern	uint64_t	FreqHR;					// Running frequency[MHz] (32.32bits)
+extern	void		SetFreqHR(uint64_t freq);
+#endif
+
+#if INCLUDE_TIMER
+#define	TIMER_TICK_HZ	(F_CPU / 16384.0)	// Timer1 CK/16384, 0.993ms
+extern	uint16_t	TimerTicks;				// Main loop time base [TIMER_TICK_HZ]
+#endif
+
+#if INCLUDE_FSK
+typedef struct
+{
+		uint32_t	Freq;					// Base frequency[MHz] (11.21bits)
+		uint32_t	Period;					// Symbol period [us]
+		int32_t		Tone[FSK_TONES];		// Tone offset[MHz] (0.32bits, signed)
+		uint8_t		Tones;					// Number of tones
+		uint8_t		Symbols;				// Number of symbols
+		uint8_t		Symbol[(FSK_SYMBOLS+1)/2];// Symbols, low nibble first
+} fsk_t;
+
+extern	fsk_t		Fsk;					// FSK tables from the host
+extern	uint8_t		FskStart(void);
+extern	void		FskStop(void);
+extern	void		FskPoll(void);
+extern	uint16_t	FskStatus(void);
+#endif
+
+#if INCLUDE_TEMP
+extern	uint16_t	GetTemperature(void);
+#endif
+
+#if INCLUDE_OSCCAL_TRACK
+extern	void		trackOscillator(uint16_t ticks);	// OSCCAL tracker (osccal.c)
+#endif
+
+#if INCLUDE_ADC_SCAN
+#define	ADC_TEMP				0			// Scan table index of the channels
+#define	ADC_PB5					1
+#define	ADC_PB4					2
+#define	ADC_VBG					3
+
+extern	void		AdcScanStart(void);
+extern	void		AdcScanStop(void);
+extern	uint16_t	AdcScanRead(uint8_t channel);
+#endif
+
+#if INCLUDE_TEMP_COMP
+typedef struct
+{
+		uint16_t	Adc;					// Temperature ADC count, 0xFFFF = not used
+		int16_t		Ppm;					// Crystal correction [0.01 ppm]
+} temppoint_t;
+
+extern	temppoint_t	TempTable[TEMP_POINTS];	// Compensation curve in eeprom
+extern	uint32_t	TempXtal;				// Crystal frequency without correction
+extern	uint16_t	TempFilt;				// Filtered temperature ADC count (12.4bits)
+extern	int16_t		TempPpm;				// Running correction [0.01 ppm]
+extern	void		TempCompPoll(void);
+#endif
+
+#if INCLUDE_CAL
+#define	CAL_IDLE				0			// Not started
+#define	CAL_WAIT				1			// Waiting for the first 1PPS edge
+#define	CAL_COUNT				2			// Counting the IO_P2 edges
+#define	CAL_DONE				3			// Done, the crystal frequency is calculated
+#define	CAL_ERROR				4			// Done, the count is out of 1000 ppm or the frequency changed
+#define	CAL_PRESCALER			0x0F		// Flags: external prescaler log2
+#define	CAL_WRITE				0x80		// Flags: use and save the crystal frequency
+
+typedef struct
+{
+		uint8_t		State;					// Calibration state
+		uint8_t		Seconds;				// Counted 1PPS seconds
+		uint32_t	Count;					// Counted IO_P2 edges
+		uint32_t	FreqXtal;				// Calculated crystal frequency[MHz] (8.24bits)
+} cal_t;
+
+extern	uint8_t		CalStart(uint8_t seconds, uint8_t flags);
+extern	void		CalStop(void);
+extern	void		CalPoll(void);
+extern	cal_t*		CalStatus(void);
+#endif
+
 #if INCLUDE_ABPF | INCLUDE_IBPF
 #define	FilterCrossOverOn	(R.FilterCrossOver[MAX_BAND-1].b0 != 0)
 #endif
 
+#if INCLUDE_FILTER_BANK
+#define	TxFilterOn			(R.TxCrossOver[TX_BANDS-1].b0 != 0)
+#endif
+
+#if INCLUDE_GPIO
+extern	uint8_t		GpioWrite(uint8_t chip, uint8_t mask, uint8_t data);
+extern	uint8_t		GpioRead(uint8_t chip);
+#endif
+
+#if INCLUDE_IBPF
+extern	void		SetFilter(uint8_t filter);
+#endif
+
+#if INCLUDE_BAND_CACHE
+extern	uint16_t	BandHigh;				// Cached band upper bound[MHz] (11.5bits)
+#define	BandCacheClear()	(BandHigh = 0)	// Empty bounds, next SetFreq searches the band
+#else
+#define	BandCacheClear()
+#endif
+
 #if INCLUDE_I2C
 //#define	I2C_KBITRATE	400.0			// I2C Bus speed in Kbs
 #define	I2C_KBITRATE	200.0				// 400 was to high?!?
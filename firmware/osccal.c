@@ -13,6 +13,9 @@
 #include <avr/pgmspace.h>
 #include "usbdrv.h"
 
+#define OSCCAL_TARGET       ((unsigned)(1499 * (double)F_CPU / 10.5e6 + 0.5))
+#define OSCCAL_TOLERANCE    (OSCCAL_TARGET / 128)   /* 0.8%, the 16.5 MHz module tolerates 1% */
+
 /* ------------------------------------------------------------------------- */
 /* ------------------------ Oscillator Calibration ------------------------- */
 /* ------------------------------------------------------------------------- */
@@ -26,7 +29,7 @@ void    calibrateOscillator(void)
 {
 uchar       step = 128;
 uchar       trialValue = 0, optimumValue;
-int         x, optimumDev, targetValue = (unsigned)(1499 * (double)F_CPU / 10.5e6 + 0.5);
+int         x, optimumDev, targetValue = OSCCAL_TARGET;
 
     /* do a binary search: */
     do{
@@ -62,12 +65,67 @@ ATTiny25, ATTiny45, ATTiny85), it may be useful to search for the optimum in
 both regions.
 */
 
+#if INCLUDE_OSCCAL_TRACK
+
+/* Track the drift of the RC oscillator (temperature) after the calibration.
+ * The SOF count (1 ms) is compared with the main loop time base of Timer1
+ * (CK/16384) over 1024 frames. A deviation of more than 0.4% (about half an
+ * OSCCAL step) changes OSCCAL by one step, the OSCCAL region (bit 7) is not
+ * changed. A window with a deviation of more than 3% (suspend, no SOF) is
+ * not used.
+ */
+static uchar    trackSofLast;
+static unsigned trackSof;
+static unsigned trackStart;
+static uchar    trackRestart = 1;
+
+void    trackOscillator(unsigned ticks)
+{
+uchar       sof = usbSofCount;
+unsigned    expect;
+int         x;
+
+    trackSof += (uchar)(sof - trackSofLast);
+    trackSofLast = sof;
+    if(trackRestart){
+        trackRestart = 0;
+        trackSof = 0;
+        trackStart = ticks;
+        return;
+    }
+    if(trackSof < 1024)
+        return;
+    /* ticks per frame F_CPU / 16384 / 1000 = 1 + 29/4096 at 16.5 MHz */
+    expect = trackSof + ((trackSof * (unsigned)(F_CPU / 16384.0 / 1000 * 4096 - 4096 + 0.5)) >> 12);
+    x = (ticks - trackStart) - expect;  /* > 0: CPU clock too fast */
+    trackSof = 0;
+    trackStart = ticks;
+    if(x > (int)(expect >> 8) && x < (int)(expect >> 5) && (OSCCAL & 0x7f) != 0x00)
+        OSCCAL--;
+    else if(x < -(int)(expect >> 8) && x > -(int)(expect >> 5) && (OSCCAL & 0x7f) != 0x7f)
+        OSCCAL++;
+}
+
+#endif
+
+/* Start with the (stored) OSCCAL value, the full calibration is only done
+ * when one frame measurement is out of the tolerance. The EEPROM is only
+ * written when the value is changed.
+ */
 void    usbEventResetReady(void)
 {
+int         x;
+
     cli();  // usbMeasureFrameLength() counts CPU cycles, so disable interrupts.
-    calibrateOscillator();
+    x = usbMeasureFrameLength() - OSCCAL_TARGET;
+    if(x < -(int)OSCCAL_TOLERANCE || x > (int)OSCCAL_TOLERANCE)
+        calibrateOscillator();
     sei();
-    eeprom_write_byte(0, OSCCAL);   // store the calibrated value in EEPROM
+    if(eeprom_read_byte(0) != OSCCAL)
+        eeprom_write_byte(0, OSCCAL);   // store the calibrated value in EEPROM
+#if INCLUDE_OSCCAL_TRACK
+    trackRestart = 1;
+#endif
 }
 
 
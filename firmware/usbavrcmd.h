@@ -43,8 +43,8 @@
 #define	CMD_SET_FILTER			0x17
 #define	CMD_SET_RX_BAND_FILTER	0x18	// V15.12
 #define	CMD_GET_RX_BAND_FILTER	0x19	// V15.12
-#define	CMD_SET_TX_BAND_FILTER	0x1a	// MOBO Only
-#define	CMD_GET_TX_BAND_FILTER	0x1b	// MOBO Only
+#define	CMD_SET_TX_BAND_FILTER	0x1a	// V15.16: Set the TX filter for band 0..15
+#define	CMD_GET_TX_BAND_FILTER	0x1b	// V15.16: Read the TX filters
 //								0x1c	// Free
 //								0x1d	// Free
 //								0x1e	// Free
@@ -68,7 +68,7 @@
 #define	CMD_GET_PPM				0x3b
 #define	CMD_GET_STARTUP			0x3c
 #define	CMD_GET_XTAL			0x3d
-#define	CMD_GET_REGS			0x3e	// V1.4: Not implemented
+#define	CMD_GET_REGS			0x3e	// V15.16: Calculate the Si570 registers of a frequency
 #define	CMD_GET_SI570			0x3f
 #define	CMD_GET_I2C_ERR			0x40
 #define	CMD_SET_I2C_ADDR		0x41
@@ -85,13 +85,41 @@
 
 // Mobo command's
 #define	CMD_GET_FW_FEATURE		0x60	// Firmware Feature select
-#define	CMD_GET_ADC_INPUTS		0x61	// Read analog inputs (Temp, PA current, P_out, P_ref, Vdd)
+#define	CMD_GET_ADC_INPUTS		0x61	// V15.16: Read analog inputs (Temp, PB5, PB4, Vcc bandgap)
 #define	CMD_RM_PA_HIGH_TEMP		0x64	// Read/Modify the PA High Temperature limit
 #define	CMD_RM_PA_BIAS			0x65	// Read/Modify PA bias setting related values, 5 items
 #define	CMD_RM_PA_SWR			0x66	// Read/Modify SWR measurement and SWR alarm related values 4 items
 #define	CMD_SET_BYTE_GPIO		0x6e	// Write a Byte to (PCF8584) GPIO Extender
 #define	CMD_GET_BYTE_GPIO		0x6f	// Read a Byte from (PCF8584) GPIO Extender
 
+#define	CMD_SET_SWEEP			0x70	// V15.16: Start the network analyzer sweep
+#define	CMD_GET_SWEEP			0x71	// V15.16: Read the sweep detector values
+#define	CMD_SET_FSK				0x72	// V15.16: Upload the FSK sequencer tables
+#define	CMD_RUN_FSK				0x73	// V15.16: Start / stop the FSK sequencer
+#define	CMD_SET_HOP				0x74	// V15.16: Load a frequency in the hop list
+#define	CMD_RUN_HOP				0x75	// V15.16: Start / stop the frequency hopping
+#define	CMD_SET_KEYER			0x76	// V15.16: Set the CW keyer mode, speed and weight
+#define	CMD_SET_SEQ				0x77	// V15.16: Load the T/R sequencer lists and TX frequency
+#define	CMD_RUN_SEQ				0x78	// V15.16: Switch the T/R sequencer to RX or TX
+#define	CMD_SET_SPLIT			0x79	// V15.16: Load the split RX or TX frequency
+#define	CMD_RUN_SPLIT			0x7a	// V15.16: Switch the split frequency to RX or TX
+#define	CMD_GET_CACHE			0x7b	// V15.16: Read the Si570 register cache hits and misses
+#define	CMD_SET_MEMORY			0x7c	// V15.16: Store the running frequency in a memory
+#define	CMD_GET_MEMORY			0x7d	// V15.16: Recall or read a memory
+#define	CMD_SET_REGS			0x7e	// V15.16: Load a batch of frequencies for cmd 0x3e
+#define	CMD_GET_TUNE			0x7f	// V15.16: Read the achieved frequency and error of the last tune
+#define	CMD_SET_FREQ_HR			0x80	// V15.16: Set the high resolution frequency (32.32 bits)
+#define	CMD_GET_FREQ_HR			0x81	// V15.16: Read the high resolution frequency (32.32 bits)
+#define	CMD_SET_BAND_RATIO		0x82	// V15.16: Set the band rational transform (num/den, image)
+#define	CMD_GET_BAND_RATIO		0x83	// V15.16: Read the band rational transforms
+#define	CMD_SET_FILTER_HYST		0x84	// V15.16: Read / write the filter cross over hysteresis
+#define	CMD_SET_CHANNEL			0x85	// V15.16: Select the Si570 channel
+#define	CMD_SET_QUAD			0x86	// V15.16: Read / write the Si5351 CLK0 & CLK1 quadrature
+#define	CMD_RUN_CAL				0x87	// V15.16: Start / read the 1PPS crystal calibration
+#define	CMD_SET_TEMP_COMP		0x88	// V15.16: Write the temperature compensation curve or step
+#define	CMD_GET_TEMP_COMP		0x89	// V15.16: Read the temperature compensation curve or status
+#define	CMD_GET_PA_ALARM		0x8a	// V15.16: Read / clear the latched PA protection alarm
+
 //								0xEE	// Used in old V2.0
 //								0xEF	// Used in old V2.0
 //								0xFF	// Used in old V2.0
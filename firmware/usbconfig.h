@@ -231,7 +231,8 @@ section at the end of this file).
 /* This macro (if defined) is executed when a USB SET_ADDRESS request was
  * received.
  */
-#define USB_COUNT_SOF                   0
+#define INCLUDE_OSCCAL_TRACK            0	// V15.16: Track the RC oscillator drift by the SOF count (osccal.c)
+#define USB_COUNT_SOF                   INCLUDE_OSCCAL_TRACK
 /* define this macro to 1 if you need the global variable "usbSofCount" which
  * counts SOF packets. This feature requires that the hardware interrupt is
  * connected to D- instead of D+.